@@ -26,128 +26,456 @@ This file is part of the Rick's Generic GA Solver project (https://launchpad.net
 #include <time.h>
 #include <confreader.h>
 #include <hires_timer.h>
-#include <boost/random.hpp>
+#include <common.h>
 // local includes.
 #include "parameters.h"
 #include "chromosome.h"
 #include "fitness_tester.h"
+#include "viable_generator.h"
 
 using namespace std;
 
-typedef vector<chromosome> c_vector;
-typedef map<float,chromosome> c_sorted;
+// -- the run settings evolve() needs beyond the globals in parameters.h.
+struct run_options
+{
+	float b_percent;
+	float d_percent;
+	float s_percent;
+	bool incremental;
+	bool early_abort;
+	bool repair;
+	bool silent;
+	bool mute;
+	bool file_headers;
+	int gdispmod;
+	// -- random key encoding only: splice, single, uniform or multipoint.
+	string key_crossover;
+	// -- points used by the multipoint key_crossover.
+	unsigned int crossover_points;
+	// -- permutation encoding only: ox, pmx or erx.
+	string crossover;
+	// -- permutation encoding only: invert instead of swapping.
+	bool inversion;
+	// -- random key encoding only: keep the population in arenas.
+	bool arena;
+};
 
-int main(int argc, char* argv[])
+/* -- the first generation. Random key chromosomes are built viable by 
+ * the viable_generator if asked; every permutation is viable.
+ */
+void populate(vector<chromosome> & list, unsigned int count, int gensize,
+	bool viable, ricks_ga::random_buffer & rng, nrtb::work_pool & pool)
 {
-	/* Obsolete arguments replaced by percentage args
-	b_count = config.get<unsigned int>("b_count",b_count);
-	unsigned int d_count = config.get<unsigned int>("d_count",b_count);
-	save_count = config.get<unsigned int>("save_count",save_count);
-	*/
+	if (viable)
+	{
+		// built viable, so there is nothing to test and throw away.
+		viable_generator generator(gensize);
+		generator.fill(list, count, rng(), pool);
+	}
+	else
+	{
+		while (list.size() < count)
+		{
+			chromosome loader;
+			loader.reload(gensize, rng);
+			list.push_back(std::move(loader));
+		};
+	};
+};
 
-	// set up our run-time variables.
-	ricks_ga::conf_reader config;
-	config.read(argc,argv,"salesman_tourney.config");
-	//-- Run control options
-	c_count = config.get<unsigned int>("c_count",c_count);
-	v_count = config.get<unsigned int>("v_count",v_count);
-	splice = !config.exists("--cross") || config.exists("--splice");
-	float b_percent = config.get<float>("b_percent",0.0)/100.0;
-	float d_percent = config.get<float>("d_percent",b_percent)/100.0;
-	float s_percent = config.get<float>("save_percent",0.0)/100.0;
-	mutations = config.get<long double>("mutations",mutations);
-	//-- Run termination options
-	samelimit = config.get<int>("samelimit",samelimit);
-	genlimit = config.get<int>("genlimit",genlimit);	
-	e_threshold = config.get<unsigned int>("e_threshold",e_threshold);
-	//-- IO options
-	outfile = config.get<string>("outfile",outfile);
-	infile = config.get<string>("infile",infile);
-	bool silent = config.exists("--silent");
-	bool world_silent = config.exists("--world-silent");
-	int gdispmod = config.get<int>("g_mod",1);
-	bool mute = config.exists("--mute");
-	bool file_headers = 
-		config.exists("--file-headers") && !config.exists("--no-file-headers");
-	
-	// Handle "flexable" parameters
-	if (b_percent <= 0.0)
+// -- fills a list of random tours on a work_pool, chunk by chunk.
+struct tour_filler: public nrtb::work_pool::task
+{
+	static const unsigned int chunk = 256;
+	tour_chromosome * list;
+	unsigned int count;
+	int gensize;
+	unsigned long long int seed;
+	void operator()(unsigned int job, unsigned int)
 	{
-		cerr << "b_percent can not be 0 or less!" << endl;
-		exit(1);
+		// each chunk has its own stream, so workers can't change the results.
+		ricks_ga::xoshiro256ss rng(seed, job);
+		unsigned int last = std::min(count, (job + 1) * chunk);
+		for (unsigned int i = job * chunk; i < last; i++)
+		{
+			list[i].reload(gensize, rng);
+		};
 	};
-	// adjust d_percent.
-	d_percent = 1.0 - d_percent;
-	
-	// enforce muteness if so ordered.
-	if (mute)
+};
+
+// -- every permutation is viable, so there is nothing to test for.
+void populate(vector<tour_chromosome> & list, unsigned int count, 
+	int gensize, bool, ricks_ga::random_buffer & rng, 
+	nrtb::work_pool & pool)
+{
+	list.resize(count);
+	if (count == 0) return;
+	tour_filler filler;
+	filler.list = &list[0];
+	filler.count = count;
+	filler.gensize = gensize;
+	filler.seed = rng();
+	pool.run((count + tour_filler::chunk - 1) / tour_filler::chunk, filler);
+};
+
+// -- random key child from parents a and b, by key_crossover.
+template <class K>
+void breed_keys(K & child, K & a, K & b, int gensize, 
+	ricks_ga::random_buffer & rng, run_options & o)
+{
+	if (o.key_crossover == "uniform")
 	{
-		silent = true;
+		child.uniform_crossover(a,b,rng);
+	}
+	else if (o.key_crossover == "multipoint")
+	{
+		child.multipoint_crossover(a,b,o.crossover_points,rng);
+	}
+	else if (o.key_crossover == "splice")
+	{
+		unsigned int start = rng.below(gensize);
+		child.splice(a,b,start,rng.below(gensize));
+	}
+	else
+	{
+		child.recombine(a,b,rng.below(gensize));
 	};
-	// simularly enforce silence
-	if (silent)
+};
+
+// -- child from parents a and b, by key_crossover or crossover.
+void breed(chromosome & child, chromosome & a, chromosome & b, int gensize,
+	ricks_ga::random_buffer & rng, run_options & o)
+{
+	breed_keys(child, a, b, gensize, rng, o);
+};
+
+void breed(tour_chromosome & child, tour_chromosome & a, 
+	tour_chromosome & b, int gensize, ricks_ga::random_buffer & rng, 
+	run_options & o)
+{
+	// breeding runs on one thread, so one workspace does.
+	static tour_chromosome::workspace w;
+	if (o.crossover == "erx")
 	{
-		world_silent = true;
+		child.edge_recombination(a,b,w);
+		return;
 	};
-	
-	// report the configuration read.
-	if (!world_silent)
+	unsigned int begin = rng.below(gensize);
+	unsigned int end = rng.below(gensize);
+	if (o.crossover == "pmx")
 	{
-		ricks_ga::conf_reader::iterator c = config.begin();
-		ricks_ga::conf_reader::iterator e = config.end();
-		cout << "Read these settings from the config file and command line:" 
-			<< endl;
-	 	while (c != e)
+		child.partially_mapped_crossover(a,b,begin,end,w);
+	}
+	else
+	{
+		child.order_crossover(a,b,begin,end,w);
+	};
+};
+
+// -- mutation of one gene, given or at random.
+void mutate(chromosome & c, unsigned int gene, ricks_ga::random_buffer & rng)
+{
+	c.mutate(gene, rng.bits());
+};
+
+void mutate(chromosome & c, ricks_ga::random_buffer & rng)
+{
+	mutate(c, rng.below(c.length()), rng);
+};
+
+void mutate(chromosome_arena::view c, unsigned int gene, 
+	ricks_ga::random_buffer & rng)
+{
+	c.mutate(gene, rng.bits());
+};
+
+void mutate(chromosome_arena::view c, ricks_ga::random_buffer & rng)
+{
+	mutate(c, rng.below(c.length()), rng);
+};
+
+// -- the city at gene is swapped with, or inverted to, a random one.
+void mutate(tour_chromosome & c, unsigned int gene, 
+	ricks_ga::random_buffer & rng, bool inversion)
+{
+	unsigned int n = c.length();
+	// the start city stays in position 0.
+	if ((n < 3) || (gene == 0)) return;
+	unsigned int j = 1 + rng.below(n - 1);
+	if (inversion)
+	{
+		c.invert(gene,j);
+	}
+	else
+	{
+		c.swap(gene,j);
+	};
+};
+
+void mutate(tour_chromosome & c, ricks_ga::random_buffer & rng, 
+	bool inversion)
+{
+	unsigned int n = c.length();
+	if (n < 3) return;
+	mutate(c, 1 + rng.below(n - 1), rng, inversion);
+};
+
+// -- what mutate_population() calls; only tours use the options.
+template <class X> void mutate(X && c, ricks_ga::random_buffer & rng, 
+	run_options &)
+{
+	mutate(c, rng);
+};
+
+template <class X> void mutate(X && c, unsigned int gene, 
+	ricks_ga::random_buffer & rng, run_options &)
+{
+	mutate(c, gene, rng);
+};
+
+void mutate(tour_chromosome & c, ricks_ga::random_buffer & rng, 
+	run_options & o)
+{
+	mutate(c, rng, o.inversion);
+};
+
+void mutate(tour_chromosome & c, unsigned int gene, 
+	ricks_ga::random_buffer & rng, run_options & o)
+{
+	mutate(c, gene, rng, o.inversion);
+};
+
+/* -- mutates the first count of list: each chromosome with odds 
+ * per_chromosome (one random gene) and each gene with odds per_gene.
+ * Only what mutates is visited, stepping over the gaps drawn by 
+ * geometric_skip, so the cost follows the number of mutations rather 
+ * than the population size. Returns the number of mutations.
+ */
+template <class P>
+unsigned int mutate_population(P & list, unsigned int count, int gensize,
+	ricks_ga::random_buffer & rng, run_options & o, 
+	ricks_ga::geometric_skip & per_chromosome, 
+	ricks_ga::geometric_skip & per_gene)
+{
+	unsigned int returnme = 0;
+	unsigned long long int at = 0;
+	while (true)
+	{
+		unsigned long long int skip = per_chromosome.next(rng);
+		if (skip >= count - at) break;
+		at += skip;
+		mutate(list[at], rng, o);
+		returnme++;
+		at++;
+	};
+	unsigned long long int genes = (unsigned long long int) count * gensize;
+	at = 0;
+	while (true)
+	{
+		unsigned long long int skip = per_gene.next(rng);
+		if (skip >= genes - at) break;
+		at += skip;
+		mutate(list[at / gensize], at % gensize, rng, o);
+		returnme++;
+		at++;
+	};
+	return returnme;
+};
+
+// -- column headings of the output file.
+void write_headings(ofstream & output)
+{
+	output << "generation"
+		<< "\t" << "best" 
+		<< "\t" << "worst" 
+		<< "\t" << "average"
+		<< "\t" << "sec"
+		<< "\t" << "viable" 
+		<< "\t" << "bred"
+		<< "\t" << "entropy"
+		<< "\t" << "mutated"
+		<< "\t" << "cache_hits"
+		<< "\t" << "cache_misses"
+		<< "\t" << "edges_saved"
+		<< "\t" << "repaired"
+		<< endl;
+};
+
+// -- what is shown and written out for each generation.
+struct generation_stats
+{
+	long int generation;
+	// -- the best length as reported, and as the fitness.
+	float best;
+	float best_fitness;
+	float worst;
+	unsigned int count;
+	unsigned int bred;
+	double entropy;
+	unsigned int mutated;
+	unsigned long long int hits;
+	unsigned long long int misses;
+	double edges_saved;
+	unsigned long long int repaired;
+};
+
+void report(generation_stats & s, nrtb::hirez_timer & gen_time, 
+	ofstream & output, run_options & o, bool cache)
+{
+	// report status
+	if (s.generation % o.gdispmod == 0)
+	{
+		if (!o.silent)
 		{
-			cout << "\t" << c->first << "=" << c->second << endl;
-			c++;
+			cout << "#" << setw(6) << s.generation << ": " 
+				<< "best " <<  s.best 
+				<< ", worst " << s.worst 
+				<< ", average "
+				<< (s.best_fitness + s.worst) /2
+				<< " (" << gen_time.interval_as_HMS() << ")."
+				<< endl;
+			cout << "\tcount: " << s.count
+				<< ", bred: " << s.bred
+				<< ", Mutated: " << s.mutated 
+				<< ", Entropy: " << s.entropy << "%";
+			if (cache)
+			{
+				cout << ", Cache hits: " << s.hits << "/" << s.hits + s.misses;
+			};
+			if (o.early_abort)
+			{
+				cout << ", Edges saved: " << s.edges_saved * 100 << "%";
+			};
+			if (o.repair)
+			{
+				cout << ", Repaired: " << s.repaired;
+			};
+			cout << endl;
+		}
+		else if (!o.mute)
+		{
+			cout << "." << flush;
 		};
 	};
+
+	output << s.generation 
+		<< "\t" << s.best
+		<< "\t" << s.worst 
+		<< "\t"
+		<< (s.best_fitness + s.worst) / 2
+		<< "\t" << gen_time.interval()
+		<< "\t" << s.count 
+		<< "\t" << s.bred
+		<< "\t" << s.entropy
+		<< "\t" << s.mutated
+		<< "\t" << s.hits
+		<< "\t" << s.misses
+		<< "\t" << s.edges_saved
+		<< "\t" << s.repaired
+		<< endl;
+};
+
+// -- the final results.
+template <class C> void final_report(C & best, float best_length, 
+	C & winner, float winner_length, long int generation, int first_best,
+	nrtb::hirez_timer & runtime, run_options & o)
+{
+	world & environment = world::get_instance();
+	if (!o.silent)
+	{
+		// output the final results.
+		cout << "==========================\n\nFinal Best: "
+			<< best_length 
+			<< "\n\t" << environment.show_route(best)
+			<< "\n" << best.enstream()
+			<< "\n\nAbsolute best: " << winner_length 
+			<< "\n\t" << environment.show_route(winner) 
+			<< "\n" << winner.enstream() 
+			<< "\n\n" << generation << " generations run, " 
+			<< first_best << " is where the best score was first found."
+			<< "\n\nTotal run time was " 
+			<< runtime.interval_as_HMS(true) << ".\n"
+			<< endl;
+	}
+	else if (!o.mute)
+	{
+		cout << "\nFinal Best = " << best_length
+			<< " (" << runtime.interval_as_HMS(true) << ")"
+			<< endl;
+	};
+};
+
+// -- stops the run when no chromosome survived to breed.
+void no_breeders(long int generation)
+{
+	cerr << "\nNo chromosomes survived to breed generation #" 
+		<< generation+1 << "." << endl;
+	exit(1);
+};
+
+/* -- the genetic algorithm itself, for either encoding. C is chromosome 
+ * or tour_chromosome; the world must be loaded already.
+ */
+template <class C> int evolve(run_options & o)
+{
+	typedef vector<C> c_vector;
+	/* -- the chromosomes stay in gen_list; the sorted and breeding 
+	 * lists hold their indexes, so a generation's stages hand 
+	 * chromosomes on without copying them.
+	 */
+	typedef map<float,unsigned int> c_sorted;
 	// -- generation data.
 	c_vector gen_list;
 	gen_list.clear();
 	gen_list.reserve(c_count);
+	// -- the survivors, moved out of gen_list, and their children.
+	c_vector next_list;
+	next_list.reserve(c_count);
 	c_sorted breeding_list;
 	breeding_list.clear();
 //	breeding_list.reserve(b_count);
 	c_sorted sorted;
-	c_vector::iterator gc;
-	c_vector::iterator ge;
 	long int generation = 0;
-	// -- fitness testing.
 	world & environment = world::get_instance();
-	environment.load(infile);
-	if (!silent && !world_silent) environment.dump();
-	// -- set chromosome length.
 	int gensize = environment.length();
+	/* -- best lengths are reported exactly; with a quantized table the 
+	 * fitness may be off by up to quantization_error().
+	 */
+	auto reported = [&](C & c) -> float
+	{
+		if (environment.quantization_error() > 0)
+		{
+			return environment.exact_length(c);
+		};
+		return c.fitness;
+	};
 	// -- sameness is used to detect run end.
 	int sameness = samelimit;
 	// -- performance tracking data.
 	long double current_best = 0.0;
 	long double absolute_best = 1.0e30;
-	chromosome winner;
+	C winner;
 	winner.fitness = absolute_best;
 	int first_best = 0;
 	// -- time mark for run time determination.
 	nrtb::hirez_timer runtime;
-	// -- seed the random number generator.
-	boost::mt19937 rng(time(NULL));
-	boost::uniform_01<boost::mt19937,float> probability(rng);
+	// -- every random choice is drawn from this, so the seed repeats a run.
+	ricks_ga::random_buffer rng(seed);
+	ricks_ga::geometric_skip chromosome_odds(mutations);
+	ricks_ga::geometric_skip gene_odds(gene_mutations);
+	// -- fitness is calculated on all available workers.
+	nrtb::work_pool pool(threads);
+	// -- optional cache of previously seen chromosomes' fitness.
+	fitness_cache * cache = 0;
+	if (cache_size > 0) 
+	{
+		// -- hits keep their tours, so incremental updates go on.
+		cache = new fitness_cache(cache_size,gensize,o.incremental);
+	};
+	parallel_updater fitness_update(pool,o.incremental,cache);
 
 	ofstream output(outfile.c_str());
-	if (file_headers)
-	{
-		output << "generation"
-			<< "\t" << "best" 
-			<< "\t" << "worst" 
-			<< "\t" << "average"
-			<< "\t" << "sec"
-			<< "\t" << "viable" 
-			<< "\t" << "bred"
-			<< "\t" << "entropy"
-			<< "\t" << "mutated"
-			<< endl;
-	};
+	if (o.file_headers) write_headings(output);
 
 	// create a random first generation
 	bool v_test = true;
@@ -156,7 +484,7 @@ int main(int argc, char* argv[])
 		v_count = c_count;
 		v_test = false;
 	};
-	if (!silent)
+	if (!o.silent)
 	{
 		cout << "\nCreating " << v_count
 			<< (!v_test ? " random " : " viable ")
@@ -164,71 +492,63 @@ int main(int argc, char* argv[])
 			<< flush;
 	};
 	nrtb::hirez_timer gen_time;
-	while (gen_list.size() < v_count)
-	{
-		chromosome loader;
-		loader.reload(gensize);
-		if (v_test)
-		{
-			environment.check_fitness(loader);
-			if (loader.fitness >= 0)
-			{
-				gen_list.push_back(loader);
-			};
-		}
-		else
-		{
-			gen_list.push_back(loader);
-		};
-	};
+	populate(gen_list, v_count, gensize, v_test, rng, pool);
 	// calculate each chromosome's fitness
-	for_each(gen_list.begin(),gen_list.end(),fitness_updater());
+	fitness_update.update(gen_list);
 	// clear out the deadwood
 	gen_list.erase(
 		remove_if(gen_list.begin(),gen_list.end(),dead_chromosome()),		
 		gen_list.end() );
-	if (!silent)
+	if (!o.silent)
 	{
 		cout << "done. (" 
 			<< gen_time.stop() << " seconds)." << endl;
 	};
 	
 	// make the sorted list.
-	gc = gen_list.begin();
-	ge = gen_list.end();
 	sorted.clear();
-	while (gc != ge)
+	for (unsigned int i=0; i < gen_list.size(); i++)
 	{
-		sorted[gc->fitness] = *gc;
-		gc++;
+		sorted[gen_list[i].fitness] = i;
 	};
 	gen_time.reset();
 	gen_time.start();
+#ifdef CHROMOSOME_COUNT_COPIES
+	unsigned long long int first_copied = gene_base::copied_bytes();
+#endif
 	// generation processing loop.
 	while ((sameness--) && (genlimit--))
 	{
 
 		// cull off the lowest performers
-		gen_list.clear();
+		next_list.clear();
 
-		c_sorted::iterator glc = sorted.begin();
-		int mv_count = (int) ceil(sorted.size() * d_percent);
+		typename c_sorted::iterator glc = sorted.begin();
+		int mv_count = (int) ceil(sorted.size() * o.d_percent);
+		// -- the fitness of the last survivor.
+		float cutoff = 0;
 		while (mv_count > 0)
 		{
-			gen_list.push_back(glc->second);
+			next_list.push_back(std::move(gen_list[glc->second]));
+			// -- the survivor's index in next_list from here on.
+			glc->second = next_list.size() - 1;
+			cutoff = glc->first;
 			glc++; 
 			mv_count--;
 		};
+		// -- the parents are picked from the survivors.
+		if (next_list.empty()) no_breeders(generation);
 
 		// select the breading group
 		breeding_list.clear();
 
 		// save the first unique genes without modification.
-		save_count = (unsigned int) ceil(s_percent * gen_list.size());
+		save_count = (unsigned int) ceil(o.s_percent * next_list.size());
 		if (save_count > 0)
 		{
-			c_sorted::iterator b_curr = sorted.begin();
-			c_sorted::iterator b_end = sorted.end();
+			// -- only survivors have indexes into next_list.
+			typename c_sorted::iterator b_curr = sorted.begin();
+			typename c_sorted::iterator b_end = glc;
 			int count = save_count;
 			while ((count--) && (b_curr != b_end))
 			{
@@ -237,55 +557,57 @@ int main(int argc, char* argv[])
 			};
 		};
 		// -- build the rest of the breeding list.
-		b_count = (unsigned int) round(b_percent * gen_list.size());
+		b_count = (unsigned int) round(o.b_percent * next_list.size());
 		if (b_count < 2)
 		{
 			b_count = 2;
 		};
-		unsigned int parentsize = gen_list.size();
+		unsigned int parentsize = next_list.size();
 		unsigned int bailout = c_count * 200;
 		while ((breeding_list.size() < b_count) && (bailout-- > 0))
 		{
 			// get two competetors at random.
-			unsigned int a = rng() % parentsize;
-			unsigned int b = rng() % parentsize;
-			chromosome & parent_a = gen_list[a];
-			chromosome & parent_b = gen_list[b];
+			unsigned int a = rng.below(parentsize);
+			unsigned int b = rng.below(parentsize);
+			C & parent_a = next_list[a];
+			C & parent_b = next_list[b];
 			// determine the winner
 			/*
 				FPS 2005-03-19.. removed all the viability checks here.
 				They are not needed because of the checks made on the 
 				population before we get to this point in the cycle.
 			*/
-			chromosome * best;
-			if (parent_a > parent_b) { best = &parent_b; }
-			else best = &parent_a;
+			unsigned int best;
+			if (parent_a > parent_b) { best = b; }
+			else best = a;
 			// store unconditionally.
-				breeding_list[best->fitness] = *best;
+				breeding_list[next_list[best].fitness] = best;
 		}; // build the breeding list.
 
-		// breed the next generation
-		chromosome child;
-		c_sorted::iterator blb = breeding_list.begin();
-		c_sorted::iterator ble = breeding_list.end();
-		c_sorted::iterator oc = blb;
-		c_sorted::iterator ic =  blb;
-		while (gen_list.size() < c_count)
+		/* breed the next generation. Children are built in place; 
+		 * next_list has room for c_count, so adding them never moves 
+		 * the parents.
+		 */
+		if (breeding_list.empty()) no_breeders(generation);
+		typename c_sorted::iterator blb = breeding_list.begin();
+		typename c_sorted::iterator ble = breeding_list.end();
+		typename c_sorted::iterator oc = blb;
+		typename c_sorted::iterator ic =  blb;
+		// -- a lone breeder is crossed with itself.
+		bool pairs = (breeding_list.size() > 1);
+		while (next_list.size() < c_count)
 		{
 			// iterate though deterministicly to build the next generation.
-			if (++ic == ble) { oc++; ic = oc; ic++; };
-			if (ic == ble) { oc = blb; ic = blb; ic++; };
+			if (pairs)
+			{
+				if (++ic == ble) { oc++; ic = oc; ic++; };
+				if (ic == ble) { oc = blb; ic = blb; ic++; };
+			};
 			try
 			{
-				if (splice)
-				{
-					child.splice(oc->second,ic->second,rng() % gensize, rng() % gensize);
-				}
-				else
-				{
-					child.recombine(oc->second,ic->second,rng() % gensize);
-				};
-				gen_list.push_back(child);
+				next_list.emplace_back();
+				breed(next_list.back(), next_list[oc->second], 
+					next_list[ic->second], gensize, rng, o);
 			}
 			catch (exception & e)
 			{
@@ -295,21 +617,23 @@ int main(int argc, char* argv[])
 				exit(1);
 			};
 		};
+		gen_list.swap(next_list);
 			
 		// introduce random mutations
-		unsigned int mutated = 0;
-		unsigned int m_count = gen_list.size();
-		for (unsigned int i=0; i < m_count; i++)
-		{
-			if (probability() <= mutations)
-			{
-				gen_list[i].mutate(rng() % gensize, rng() );
-				mutated++;
-			};
-		};
+		unsigned int mutated = mutate_population(gen_list, gen_list.size(),
+			gensize, rng, o, chromosome_odds, gene_odds);
 
 		// calculate each chromosome's fitness
-		for_each(gen_list.begin(),gen_list.end(),fitness_updater());
+		if (cache) cache->reset_counts();
+		/* -- children longer than the last survivor are unlikely to 
+		 * survive the next cull, so with --early-abort their tours are 
+		 * only added up until they pass it.
+		 */
+		fitness_update.update(gen_list, o.early_abort ? cutoff : 0);
+		double edges_saved = fitness_update.edges_saved();
+		unsigned long long int repaired = fitness_update.repaired();
+		unsigned long long int hits = cache ? cache->hits() : 0;
+		unsigned long long int misses = cache ? cache->misses() : 0;
 		
 		// clear out the deadwood
 		gen_list.erase(
@@ -318,66 +642,321 @@ int main(int argc, char* argv[])
 			
 		// make the sorted list.
 		sorted.clear();
-		gc = gen_list.begin();
-		ge = gen_list.end();
-		while (gc != ge)
+		for (unsigned int i=0; i < gen_list.size(); i++)
 		{
-			sorted[gc->fitness] = *gc;
-			gc++;
+			sorted[gen_list[i].fitness] = i;
 		};
 
 		generation++;
 		gen_time.stop();
-		double entropy = sorted.size()*100.0/gen_list.size();
+		generation_stats stats;
+		stats.generation = generation;
+		C & best = gen_list[sorted.begin()->second];
+		stats.best = reported(best);
+		stats.best_fitness = best.fitness;
+		stats.worst = sorted.rbegin()->first;
+		stats.count = gen_list.size();
+		stats.bred = breeding_list.size();
+		stats.entropy = sorted.size()*100.0/gen_list.size();
+		stats.mutated = mutated;
+		stats.hits = hits;
+		stats.misses = misses;
+		stats.edges_saved = edges_saved;
+		stats.repaired = repaired;
+		report(stats, gen_time, output, o, cache != 0);
 
-		// report status
-		if (generation % gdispmod == 0)
+		// adjust exit counter.
+		if (current_best !=  best.fitness)
 		{
-			if (!silent)
+			current_best = best.fitness;
+			if (winner.fitness > current_best) 
 			{
-				cout << "#" << setw(6) << generation << ": " 
-					<< "best " <<  sorted.begin()->second.fitness 
-					<< ", worst " << sorted.rbegin()->second.fitness 
-					<< ", average "
-					<< (sorted.begin()->second.fitness + sorted.rbegin()->second.fitness) /2
-					<< " (" << gen_time.interval_as_HMS() << ")."
-					<< endl;
-				cout << "\tcount: " << gen_list.size()
-					<< ", bred: " << breeding_list.size()
-					<< ", Mutated: " << mutated 
-					<< ", Entropy: " << entropy << "%"
-					<< endl;
+				winner = best;
+				first_best = generation;
+			};
+			sameness = samelimit;
+		};
+		if (stats.entropy > e_threshold)
+		{
+			sameness = samelimit;
+		};
+
+		// start the clock for the next generation.
+		gen_time.reset();
+		gen_time.start();
+	};
+
+	runtime.stop();
+	C & best = gen_list[sorted.begin()->second];
+	final_report(best, reported(best),
+		winner, reported(winner), generation, first_best, runtime, o);
+#ifdef CHROMOSOME_COUNT_COPIES
+	// -- see basic_chromosome::copied_bytes().
+	if (!o.mute)
+	{
+		cout << "Gene bytes copied per generation: "
+			<< (gene_base::copied_bytes() - first_copied) 
+				/ std::max(generation, 1L)
+			<< endl;
+	};
+#endif
+	delete cache;
+	return 0;
+};
+
+/* -- the genetic algorithm on random key chromosomes kept in two 
+ * arenas (see chromosome_arena) instead of chromosome objects: each 
+ * generation's survivors and children are written into the arena not 
+ * in use, which then takes over, so a generation allocates nothing. 
+ * It makes the same choices as evolve<chromosome> does without 
+ * --incremental, and so gives the same run for a seed, except that 
+ * with --early-abort survivors keep the lengths they were given 
+ * instead of being scored again against the new cutoff.
+ */
+int evolve_arena(run_options & o)
+{
+	world & environment = world::get_instance();
+	int gensize = environment.length();
+	long int generation = 0;
+	// -- create a random first generation (see below).
+	bool v_test = true;
+	if (v_count == 0)
+	{
+		v_count = c_count;
+		v_test = false;
+	};
+	// -- the current generation and the next.
+	unsigned int rows = std::max(c_count, v_count);
+	chromosome_arena current(rows,gensize);
+	chromosome_arena next(rows,gensize);
+	/* -- the rows of the current generation that are alive, by fitness
+	 * and one per fitness value: the one added last, as a map would 
+	 * keep.
+	 */
+	vector<unsigned int> sorted;
+	sorted.reserve(rows);
+	// -- the survivors chosen to breed, by row of next.
+	vector<unsigned char> chosen;
+	chosen.reserve(rows);
+	vector<unsigned int> breeding_list;
+	breeding_list.reserve(rows);
+	/* -- sorts the live rows of current into sorted and returns how many
+	 * there were.
+	 */
+	auto sort_rows = [&]() -> unsigned int
+	{
+		sorted.clear();
+		for (unsigned int i=0; i < current.size(); i++)
+		{
+			if (current[i].fitness() >= 0) sorted.push_back(i);
+		};
+		unsigned int live = sorted.size();
+		std::sort(sorted.begin(), sorted.end(), 
+			[&](unsigned int a, unsigned int b) -> bool
+			{
+				float fa = current[a].fitness();
+				float fb = current[b].fitness();
+				return (fa < fb) || ((fa == fb) && (a > b));
+			});
+		sorted.erase(std::unique(sorted.begin(), sorted.end(),
+			[&](unsigned int a, unsigned int b) -> bool
+			{
+				return current[a].fitness() == current[b].fitness();
+			}), sorted.end());
+		return live;
+	};
+	// -- rows are copied out to chromosomes for reporting.
+	chromosome best;
+	auto load = [&](chromosome & c, chromosome_arena::view row)
+	{
+		c.load(row.data(), gensize);
+		c.fitness = row.fitness();
+	};
+	auto reported = [&](chromosome & c) -> float
+	{
+		if (environment.quantization_error() > 0)
+		{
+			return environment.exact_length(c);
+		};
+		return c.fitness;
+	};
+	// -- sameness is used to detect run end.
+	int sameness = samelimit;
+	// -- performance tracking data.
+	long double current_best = 0.0;
+	long double absolute_best = 1.0e30;
+	chromosome winner;
+	winner.fitness = absolute_best;
+	int first_best = 0;
+	// -- time mark for run time determination.
+	nrtb::hirez_timer runtime;
+	// -- every random choice is drawn from this, so the seed repeats a run.
+	ricks_ga::random_buffer rng(seed);
+	ricks_ga::geometric_skip chromosome_odds(mutations);
+	ricks_ga::geometric_skip gene_odds(gene_mutations);
+	// -- fitness is calculated on all available workers.
+	nrtb::work_pool pool(threads);
+	parallel_updater fitness_update(pool);
+
+	ofstream output(outfile.c_str());
+	if (o.file_headers) write_headings(output);
+
+	if (!o.silent)
+	{
+		cout << "\nCreating " << v_count
+			<< (!v_test ? " random " : " viable ")
+			<< "chromosomes... "  
+			<< flush;
+	};
+	nrtb::hirez_timer gen_time;
+	{
+		vector<chromosome> first;
+		populate(first, v_count, gensize, v_test, rng, pool);
+		for (unsigned int i=0; i < first.size(); i++)
+		{
+			current.add().load(first[i].data());
+		};
+	};
+	// calculate each chromosome's fitness
+	fitness_update.update(current);
+	if (!o.silent)
+	{
+		cout << "done. (" 
+			<< gen_time.stop() << " seconds)." << endl;
+	};
+	
+	// make the sorted list.
+	unsigned int live = sort_rows();
+	gen_time.reset();
+	gen_time.start();
+	// generation processing loop.
+	while ((sameness--) && (genlimit--))
+	{
+		// cull off the lowest performers
+		next.clear();
+		unsigned int mv_count = (unsigned int) ceil(sorted.size() * o.d_percent);
+		// -- the fitness of the last survivor.
+		float cutoff = 0;
+		for (unsigned int i=0; i < mv_count; i++)
+		{
+			next.add().copy(current[sorted[i]]);
+			cutoff = current[sorted[i]].fitness();
+		};
+		if (next.size() == 0) no_breeders(generation);
+
+		/* select the breeding group. The survivors are in fitness order
+		 * and no two have the same fitness, so choosing one by fitness 
+		 * is choosing its row.
+		 */
+		chosen.assign(mv_count,0);
+		unsigned int bred = 0;
+		// save the first unique genes without modification.
+		save_count = (unsigned int) ceil(o.s_percent * next.size());
+		for (unsigned int i=0; (i < save_count) && (i < mv_count); i++)
+		{
+			chosen[i] = 1;
+			bred++;
+		};
+		// -- build the rest of the breeding list.
+		b_count = (unsigned int) round(o.b_percent * next.size());
+		if (b_count < 2)
+		{
+			b_count = 2;
+		};
+		unsigned int parentsize = next.size();
+		unsigned int bailout = c_count * 200;
+		while ((bred < b_count) && (bailout-- > 0))
+		{
+			// get two competetors at random.
+			unsigned int a = rng.below(parentsize);
+			unsigned int b = rng.below(parentsize);
+			// determine the winner
+			unsigned int best_row = 
+				(next[a].fitness() > next[b].fitness()) ? b : a;
+			if (!chosen[best_row])
+			{
+				chosen[best_row] = 1;
+				bred++;
+			};
+		}; // build the breeding list.
+		breeding_list.clear();
+		for (unsigned int i=0; i < mv_count; i++)
+		{
+			if (chosen[i]) breeding_list.push_back(i);
+		};
+
+		// breed the next generation; a lone breeder is crossed with itself.
+		unsigned int ble = breeding_list.size();
+		if (ble == 0) no_breeders(generation);
+		unsigned int oc = 0;
+		unsigned int ic = 0;
+		while (next.size() < c_count)
+		{
+			// iterate though deterministicly to build the next generation.
+			if (ble > 1)
+			{
+				if (++ic == ble) { oc++; ic = oc; ic++; };
+				if (ic == ble) { oc = 0; ic = 1; };
+			};
+			try
+			{
+				chromosome_arena::view child = next.add();
+				chromosome_arena::view a = next[breeding_list.at(oc)];
+				chromosome_arena::view b = next[breeding_list.at(ic)];
+				breed_keys(child, a, b, gensize, rng, o);
 			}
-			else if (!mute)
+			catch (exception & e)
 			{
-				cout << "." << flush;
+				cerr << "\nError \"" << e.what()
+					<< "\" building generation #" << generation+1
+					<< endl;
+				exit(1);
 			};
 		};
+			
+		// introduce random mutations
+		unsigned int mutated = mutate_population(next, next.size(),
+			gensize, rng, o, chromosome_odds, gene_odds);
 
-		output << generation 
-			<< "\t" << sorted.begin()->second.fitness
-			<< "\t" << sorted.rbegin()->second.fitness 
-			<< "\t"
-			<< (sorted.begin()->second.fitness + sorted.rbegin()->second.fitness) / 2
-			<< "\t" << gen_time.interval()
-			<< "\t" << gen_list.size() 
-			<< "\t" << breeding_list.size()
-			<< "\t" << entropy
-			<< "\t" << mutated
-			<< endl;
+		// calculate the fitness of each changed chromosome
+		fitness_update.update(next, o.early_abort ? cutoff : 0);
+		double edges_saved = fitness_update.edges_saved();
+		unsigned long long int repaired = fitness_update.repaired();
+
+		// the next generation takes over; dead rows are left out of sorted.
+		current.swap(next);
+		live = sort_rows();
+
+		generation++;
+		gen_time.stop();
+		load(best, current[sorted.front()]);
+		generation_stats stats;
+		stats.generation = generation;
+		stats.best = reported(best);
+		stats.best_fitness = best.fitness;
+		stats.worst = current[sorted.back()].fitness();
+		stats.count = live;
+		stats.bred = ble;
+		stats.entropy = sorted.size()*100.0/live;
+		stats.mutated = mutated;
+		stats.hits = 0;
+		stats.misses = 0;
+		stats.edges_saved = edges_saved;
+		stats.repaired = repaired;
+		report(stats, gen_time, output, o, false);
 
 		// adjust exit counter.
-		if (current_best !=  sorted.begin()->second.fitness)
+		if (current_best != best.fitness)
 		{
-			current_best = sorted.begin()->second.fitness;
+			current_best = best.fitness;
 			if (winner.fitness > current_best) 
 			{
-				winner = sorted.begin()->second;
+				winner = best;
 				first_best = generation;
 			};
 			sameness = samelimit;
 		};
-		if (entropy > e_threshold)
+		if (stats.entropy > e_threshold)
 		{
 			sameness = samelimit;
 		};
@@ -388,28 +967,213 @@ int main(int argc, char* argv[])
 	};
 
 	runtime.stop();
-	if (!silent)
+	load(best, current[sorted.front()]);
+	final_report(best, reported(best), winner, reported(winner), 
+		generation, first_best, runtime, o);
+	return 0;
+};
+
+int main(int argc, char* argv[])
+{
+	/* Obsolete arguments replaced by percentage args
+	b_count = config.get<unsigned int>("b_count",b_count);
+	unsigned int d_count = config.get<unsigned int>("d_count",b_count);
+	save_count = config.get<unsigned int>("save_count",save_count);
+	*/
+
+	// set up our run-time variables.
+	ricks_ga::conf_reader config;
+	config.read(argc,argv,"salesman_tourney.config");
+	//-- Run control options
+	c_count = config.get<unsigned int>("c_count",c_count);
+	v_count = config.get<unsigned int>("v_count",v_count);
+	splice = !config.exists("--cross") || config.exists("--splice");
+	float b_percent = config.get<float>("b_percent",0.0)/100.0;
+	float d_percent = config.get<float>("d_percent",b_percent)/100.0;
+	float s_percent = config.get<float>("save_percent",0.0)/100.0;
+	mutations = config.get<long double>("mutations",mutations);
+	gene_mutations = config.get<long double>("gene_mutations",gene_mutations);
+	threads = config.get<unsigned int>("threads",threads);
+	bool force_full = config.exists("--full-eval");
+	bool force_incremental = config.exists("--incremental");
+	bool early_abort = config.exists("--early-abort");
+	bool repair = config.exists("--repair");
+	bool arena = config.exists("--arena");
+	cache_size = config.get<unsigned int>("cache_size",cache_size);
+	string encoding = config.get<string>("encoding","random_key");
+	string crossover = config.get<string>("crossover","ox");
+	string key_crossover = config.get<string>("key_crossover",
+		splice ? "splice" : "single");
+	unsigned int crossover_points = 
+		config.get<unsigned int>("crossover_points",3);
+	string perm_mutation = config.get<string>("perm_mutation","swap");
+	seed = config.get<unsigned long int>("seed",time(NULL));
+	//-- Run termination options
+	samelimit = config.get<int>("samelimit",samelimit);
+	genlimit = config.get<int>("genlimit",genlimit);	
+	e_threshold = config.get<unsigned int>("e_threshold",e_threshold);
+	//-- IO options
+	outfile = config.get<string>("outfile",outfile);
+	infile = config.get<string>("infile",infile);
+	string instance_cache = config.get<string>("instance_cache","");
+	string numbering = config.get<string>("renumber","none");
+	unsigned int quantize = config.get<unsigned int>("quantize",0);
+	double quant_scale = config.get<double>("quant_scale",0.0);
+	bool silent = config.exists("--silent");
+	bool world_silent = config.exists("--world-silent");
+	int gdispmod = config.get<int>("g_mod",1);
+	bool mute = config.exists("--mute");
+	bool file_headers = 
+		config.exists("--file-headers") && !config.exists("--no-file-headers");
+	
+	// Handle "flexable" parameters
+	if (b_percent <= 0.0)
 	{
-		// output the final results.
-		cout << "==========================\n\nFinal Best: "
-			<< sorted.begin()->second.fitness 
-			<< "\n\t" << environment.show_route(sorted.begin()->second)
-			<< "\n" << sorted.begin()->second.enstream()
-			<< "\n\nAbsolute best: " << winner.fitness 
-			<< "\n\t" << environment.show_route(winner) 
-			<< "\n" << winner.enstream() 
-			<< "\n\n" << generation << " generations run, " 
-			<< first_best << " is where the best score was first found."
-			<< "\n\nTotal run time was " 
-			<< runtime.interval_as_HMS(true) << ".\n"
+		cerr << "b_percent can not be 0 or less!" << endl;
+		exit(1);
+	};
+	if ((encoding != "random_key") && (encoding != "permutation"))
+	{
+		cerr << "encoding must be random_key or permutation, not \"" 
+			<< encoding << "\"." << endl;
+		exit(1);
+	};
+	if ((crossover != "ox") && (crossover != "pmx") && (crossover != "erx"))
+	{
+		cerr << "crossover must be ox, pmx or erx, not \"" 
+			<< crossover << "\"." << endl;
+		exit(1);
+	};
+	if ((key_crossover != "splice") && (key_crossover != "single")
+		&& (key_crossover != "uniform") && (key_crossover != "multipoint"))
+	{
+		cerr << "key_crossover must be splice, single, uniform or "
+			<< "multipoint, not \"" << key_crossover << "\"." << endl;
+		exit(1);
+	};
+	if ((crossover_points < 1) 
+		|| (crossover_points > ricks_ga::max_crossover_points))
+	{
+		cerr << "crossover_points must be from 1 to " 
+			<< ricks_ga::max_crossover_points << "." << endl;
+		exit(1);
+	};
+	if ((perm_mutation != "swap") && (perm_mutation != "inversion"))
+	{
+		cerr << "perm_mutation must be swap or inversion, not \"" 
+			<< perm_mutation << "\"." << endl;
+		exit(1);
+	};
+	// the fitness cache only knows random key chromosomes.
+	if (encoding == "permutation") cache_size = 0;
+	if (arena && (cache_size > 0))
+	{
+		cerr << "cache_size can not be used with --arena." << endl;
+		exit(1);
+	};
+	// adjust d_percent.
+	d_percent = 1.0 - d_percent;
+	
+	// enforce muteness if so ordered.
+	if (mute)
+	{
+		silent = true;
+	};
+	// simularly enforce silence
+	if (silent)
+	{
+		world_silent = true;
+	};
+	
+	// report the configuration read.
+	if (!world_silent)
+	{
+		ricks_ga::conf_reader::iterator c = config.begin();
+		ricks_ga::conf_reader::iterator e = config.end();
+		cout << "Read these settings from the config file and command line:" 
 			<< endl;
+	 	while (c != e)
+		{
+			cout << "\t" << c->first << "=" << c->second << endl;
+			c++;
+		};
+		cout << "Random seed is " << seed << endl;
+	};
+	// -- fitness testing.
+	world & environment = world::get_instance();
+	nrtb::hirez_timer load_time;
+	environment.cache_in(instance_cache);
+	if (numbering == "hilbert")
+	{
+		environment.renumber(world::hilbert_numbering);
 	}
-	else if (!mute)
+	else if (numbering == "morton")
 	{
-		cout << "\nFinal Best = " << sorted.begin()->second.fitness
-			<< " (" << runtime.interval_as_HMS(true) << ")"
+		environment.renumber(world::morton_numbering);
+	}
+	else if (numbering != "none")
+	{
+		cerr << "renumber must be hilbert, morton or none, not \"" 
+			<< numbering << "\"." << endl;
+		exit(1);
+	};
+	environment.quantize(quantize,quant_scale);
+	environment.repair(repair);
+	environment.load(infile);
+	load_time.stop();
+	if (!silent && !world_silent) environment.dump();
+	if (!silent)
+	{
+		cout << "Loaded " << environment.length() << " cities from " 
+			<< infile << " in " << load_time.interval() << " seconds; "
+			<< nrtb::resident_kb() / 1024 << "MB resident"
+			<< (environment.used_cache() ? " (derived data cached)." : ".")
 			<< endl;
+		if (environment.quantization_error() > 0)
+		{
+			cout << "Distance table quantized to " << quantize << " bits: "
+				<< environment.table_bytes() / 1024 << "KB, fitness within " 
+				<< environment.quantization_error() << " of the tour length."
+				<< endl;
+		};
 	};
-	return 0;
+	// -- set chromosome length.
+	int gensize = environment.length();
+	if (GENE_SLOTS && (encoding == "random_key") && (gensize > GENE_SLOTS))
+	{
+		cerr << "This build's chromosomes hold at most " << GENE_SLOTS 
+			<< " genes, too few for " << gensize << " cities; rebuild with "
+			<< "a larger GENE_SLOTS (or 0)." << endl;
+		exit(1);
+	};
+	/* -- incremental fitness updates are only close to the full ones, 
+	 * so they are only used when asked for.
+	 */
+	bool incremental = force_incremental && !force_full;
+	// -- everything else depends on the encoding.
+	run_options options;
+	options.b_percent = b_percent;
+	options.d_percent = d_percent;
+	options.s_percent = s_percent;
+	options.incremental = incremental;
+	options.early_abort = early_abort;
+	options.repair = repair;
+	options.silent = silent;
+	options.mute = mute;
+	options.file_headers = file_headers;
+	options.gdispmod = gdispmod;
+	options.crossover = crossover;
+	options.key_crossover = key_crossover;
+	options.crossover_points = crossover_points;
+	options.inversion = (perm_mutation == "inversion");
+	options.arena = arena;
+	if (encoding == "permutation")
+	{
+		return evolve<tour_chromosome>(options);
+	};
+	if (arena)
+	{
+		return evolve_arena(options);
+	};
+	return evolve<chromosome>(options);
 };
-
@@ -21,16 +21,26 @@ This file is part of the Rick's Generic GA Solver project (https://launchpad.net
 
 #include "chromosome.h"
 
+// -- the generation loop and std::vector rely on these never copying.
+static_assert(std::is_nothrow_move_constructible<chromosome>::value &&
+	std::is_nothrow_move_assignable<chromosome>::value,
+	"chromosome moves must be noexcept");
+static_assert(std::is_nothrow_move_constructible<tour_chromosome>::value &&
+	std::is_nothrow_move_assignable<tour_chromosome>::value,
+	"tour_chromosome moves must be noexcept");
+
 void chromosome::recombine(chromosome & a, chromosome & b, unsigned int w)
 {
-	ricks_ga::basic_chromosome<genetype>::recombine(a,b,w);
+	gene_base::recombine(a,b,w);
 	fitness = 0;
+	cut_off = false;
 };
 
 void chromosome::splice(chromosome & a, chromosome & b, unsigned int s, unsigned int e)
 {
-	ricks_ga::basic_chromosome<genetype>::splice(a,b,s,e);
+	gene_base::splice(a,b,s,e);
 	fitness = 0;
+	cut_off = false;
 };
 
 int operator <(const chromosome &a,const chromosome &b)
@@ -47,3 +57,13 @@ int operator ==(const chromosome &a,const chromosome &b)
 {
 	return (a.fitness == b.fitness);
 };
+
+int operator <(const tour_chromosome &a,const tour_chromosome &b)
+{
+	return (a.fitness < b.fitness);
+};
+
+int operator >(const tour_chromosome &a,const tour_chromosome &b)
+{
+	return (a.fitness > b.fitness);
+};
@@ -23,19 +23,65 @@ This file is part of the Rick's Generic GA Solver project (https://launchpad.net
 #define chromosome_h
 
 #include <basic_chromosome.h>
+#include <permutation_chromosome.h>
+#include <gene_arena.h>
 
 /*************************************
 	This group is used to define the 
 	chromosome used.
 *************************************/
-// type of genes in the chromosomes
+/* type of genes in the chromosomes. Wider genes make ties between 
+ * keys rare in large worlds (past a few hundred cities 8 bit keys tie
+ * constantly) at the cost of memory. Set with GENE_BITS=8, 16 or 32
+ * on the make command line; do a "make clean" after changing it.
+ */
+#ifndef GENE_BITS
+#define GENE_BITS 8
+#endif
+#if GENE_BITS == 8
 typedef unsigned char genetype;
+#elif GENE_BITS == 16
+typedef unsigned short genetype;
+#elif GENE_BITS == 32
+typedef unsigned int genetype;
+#else
+#error GENE_BITS must be 8, 16 or 32
+#endif
+/* genes held in each chromosome itself (see basic_chromosome). 0, the
+ * default, keeps them on the heap, which suits any world; otherwise 
+ * worlds of more than GENE_SLOTS cities are refused. Set with 
+ * GENE_SLOTS=n on the make command line; do a "make clean" after 
+ * changing it.
+ */
+#ifndef GENE_SLOTS
+#define GENE_SLOTS 0
+#endif
+typedef ricks_ga::basic_chromosome<genetype,GENE_SLOTS> gene_base;
 
-class chromosome : public ricks_ga::basic_chromosome<genetype>
+class chromosome : public gene_base
 {
 	public: 
 		float fitness;
-		chromosome() { fitness = 0.0; };
+		/** The cities in the order visited, as of the last fitness check,
+		 ** by the world's internal numbers (see world::renumber()).
+		 ** 
+		 ** Only filled in by world::update_fitness(); used there to 
+		 ** rescore the chromosome cheaply after a single mutation.
+		 **/
+		std::vector<unsigned int> tour;
+		/** True if the last fitness check stopped early because the tour
+		 ** was already longer than the cutoff it was given (see 
+		 ** world::check_fitness()); fitness is then only a lower bound.
+		 **/
+		bool cut_off;
+		chromosome() { fitness = 0.0; cut_off = false; };
+		chromosome(const chromosome & source) = default;
+		/** Hands the genes and tour over without copying them (see 
+		 ** basic_chromosome's move constructor).
+		 **/
+		chromosome(chromosome && source) noexcept = default;
+		chromosome & operator =(const chromosome & source) = default;
+		chromosome & operator =(chromosome && source) noexcept = default;
 		void recombine(chromosome & a, chromosome & b, unsigned int w);
 		void splice(chromosome & a, chromosome & b, unsigned int s, unsigned int e);
 };
@@ -44,5 +90,28 @@ int operator <(const chromosome &a,const chromosome &b);
 int operator >(const chromosome &a,const chromosome &b);
 int operator ==(const chromosome &a,const chromosome &b);
 
+/** A whole population of random key chromosomes in one block; see 
+ ** world::check_fitness() and parallel_updater::update().
+ **/
+typedef ricks_ga::gene_arena<genetype> chromosome_arena;
+
+/** Chromosome holding the tour itself: the cities by their number in 
+ ** the city list, in the order visited, starting with city 0.
+ ** 
+ ** The alternative to the random key chromosome above; it needs no 
+ ** decoding and is never dead. See world::check_fitness().
+ **/
+class tour_chromosome : public ricks_ga::permutation_chromosome<unsigned int>
+{
+	public: 
+		float fitness;
+		/// As chromosome::cut_off.
+		bool cut_off;
+		tour_chromosome() { fitness = 0.0; cut_off = false; };
+};
+
+int operator <(const tour_chromosome &a,const tour_chromosome &b);
+int operator >(const tour_chromosome &a,const tour_chromosome &b);
+
 #endif // chromosome_h
 
@@ -0,0 +1,152 @@
+/***********************************************
+This file is part of the Rick's Generic GA Solver project (https://launchpad.net/ricks-ga).
+
+    Rick's Generic GA Solver is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Rick's Generic GA Solver is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Rick's Generic GA Solver.  If not, see <http://www.gnu.org/licenses/>.
+
+***********************************************/
+// gene arena test program
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <iostream>
+#include "basic_chromosome.h"
+#include "gene_arena.h"
+
+using namespace std;
+
+typedef ricks_ga::basic_chromosome<unsigned short> chromosome;
+typedef ricks_ga::gene_arena<unsigned short> arena;
+
+// true if v holds the same genes as c.
+bool same(arena::view v, chromosome & c)
+{
+	if (v.length() != c.length()) return false;
+	for (unsigned int i=0; i < c.length(); i++)
+	{
+		if (v[i] != c[i]) return false;
+	};
+	return true;
+};
+
+int main()
+{
+	srand48(1);
+	int failures = 0;
+	unsigned int sizes[] = {1,2,3,31,32,33,100,1000};
+	for (unsigned int s=0; s < sizeof(sizes)/sizeof(int); s++)
+	{
+		unsigned int n = sizes[s];
+		arena parents(2,n);
+		arena children(3,n);
+		chromosome a, b, child;
+		a.reload(n);
+		b.reload(n);
+		parents.add().load(&a[0]);
+		parents.add().load(&b[0]);
+		arena::view va = parents[0];
+		arena::view vb = parents[1];
+		arena::view vc = children.add();
+		// every row starts on a 64 byte boundary.
+		if (((uintptr_t) children.add().data() % 64) 
+			|| ((uintptr_t) vb.data() % 64))
+		{
+			cerr << "misaligned row at n=" << n << endl;
+			failures++;
+		};
+		if (!same(va,a) || !same(vb,b) || (va.enstream() != a.enstream()))
+		{
+			cerr << "load failed at n=" << n << endl;
+			failures++;
+		};
+		for (unsigned int t=0; t < 100; t++)
+		{
+			unsigned int x = lrand48() % n;
+			unsigned int y = lrand48() % n;
+			child.splice(a,b,x,y);
+			vc.splice(va,vb,x,y);
+			if (!same(vc,child)) 
+			{
+				cerr << "splice mismatch at n=" << n << endl;
+				failures++;
+			};
+			child.recombine(a,b,x);
+			vc.recombine(va,vb,x);
+			if (!same(vc,child)) 
+			{
+				cerr << "recombine mismatch at n=" << n << endl;
+				failures++;
+			};
+			unsigned short g = lrand48();
+			child.mutate(y,g);
+			vc.mutate(y,g);
+			child.rotate(g);
+			vc.rotate(g);
+			if (!same(vc,child)) 
+			{
+				cerr << "mutate/rotate mismatch at n=" << n << endl;
+				failures++;
+			};
+			// the child may be a parent.
+			arena::view vd = children[1];
+			vd.copy(vb);
+			child.splice(a,b,x,y);
+			vd.splice(va,vd,x,y);
+			if (!same(vd,child)) 
+			{
+				cerr << "self splice mismatch at n=" << n << endl;
+				failures++;
+			};
+		};
+		vc.mark_clean();
+		vc.fitness() = 1.5;
+		children[1].copy(vc);
+		if (children[1].changed() || (children[1].fitness() != 1.5))
+		{
+			cerr << "copy lost the fitness at n=" << n << endl;
+			failures++;
+		};
+		// bad indices are refused.
+		try
+		{
+			vc.splice(va,vb,n,0);
+			failures++;
+		}
+		catch (arena::splice_error & e) {};
+		try
+		{
+			vc.recombine(va,vb,n);
+			failures++;
+		}
+		catch (arena::recombine_error & e) {};
+		children.add();
+		try
+		{
+			children.add();
+			failures++;
+		}
+		catch (arena::capacity_error & e) {};
+		// rows and their fitness change sides in a swap.
+		parents.swap(children);
+		if ((parents.size() != 3) || (children.size() != 2) 
+			|| (parents[1].fitness() != 1.5) || !same(children[1],b))
+		{
+			cerr << "swap failed at n=" << n << endl;
+			failures++;
+		};
+		parents.clear();
+		if (parents.size() || (parents.capacity() != 3)) failures++;
+	};
+	cout << "gene_arena: " << failures << " failures." << endl;
+	return failures;
+};
@@ -23,9 +23,15 @@ This file is part of the Rick's Generic GA Solver project (https://launchpad.net
 
 #include <stdio.h>
 #include <vector>
+#include <array>
+#include <type_traits>
 #include <algorithm>
 #include <math.h>
 #include <iostream>
+#include <atomic>
+#include <utility>
+#include "random_engine.h"
+#include "crossover_kernels.h"
 
 namespace ricks_ga
 {
@@ -39,16 +45,93 @@ namespace ricks_ga
  ** basic_chromosome should work with any integer (char, short, long, etc.) 
  ** type without modification. By overiding the *stream and mutate functions
  ** other data types can be supported as needed.
+ ** 
+ ** If N is above 0 the genes are kept in the chromosome itself and no 
+ ** more than N fit (see capacity_error); otherwise they are kept in a 
+ ** std::vector.
  **/
-template <class G>
+template <class G, unsigned int N = 0>
 class basic_chromosome
 {
 	private:
-		std::vector<G> genlist;
+		/* storage for up to N genes inside the chromosome itself, with
+		 * the parts of the std::vector interface used below.
+		 */
+		class inline_genes
+		{
+			private:
+				std::array<G, (N ? N : 1)> genes;
+				unsigned int count;
+			public:
+				inline_genes() { count = 0; };
+				// only the genes in use are copied.
+				inline_genes(const inline_genes & source) 
+				{ 
+					count = 0;
+					assign(source.data(), source.data() + source.count);
+				};
+				inline_genes & operator =(const inline_genes & source)
+				{
+					assign(source.data(), source.data() + source.count);
+					return *this;
+				};
+				/* there is nothing to take over, so a move copies the 
+				 * genes too; source never holds more than N.
+				 */
+				inline_genes(inline_genes && source) noexcept
+				{
+					count = source.count;
+					std::copy(source.data(), source.data() + count, genes.begin());
+					source.count = 0;
+				};
+				inline_genes & operator =(inline_genes && source) noexcept
+				{
+					count = source.count;
+					std::copy(source.data(), source.data() + count, genes.begin());
+					source.count = 0;
+					return *this;
+				};
+				unsigned int size() const { return count; };
+				void clear() { count = 0; };
+				void resize(unsigned int n)
+				{
+					if (n > N) throw capacity_error();
+					if (n > count) std::fill(&genes[count], &genes[0] + n, G());
+					count = n;
+				};
+				void push_back(G value)
+				{
+					if (count == N) throw capacity_error();
+					genes[count++] = value;
+				};
+				void assign(const G * first, const G * last)
+				{
+					if (last - first > N) throw capacity_error();
+					std::copy(first, last, genes.begin());
+					count = last - first;
+				};
+				G * data() { return genes.data(); };
+				const G * data() const { return genes.data(); };
+				G * begin() { return genes.data(); };
+				G * end() { return genes.data() + count; };
+				G & operator [](unsigned int i) { return genes[i]; };
+		};
+		// the genes: on the heap if N is 0, else in the chromosome.
+		typedef typename std::conditional<N == 0, std::vector<G>, 
+			inline_genes>::type gene_list;
+		gene_list genlist;
 		int mutation_index;
 		int mutation_value;
+		int change_state;
+		G replaced_value;
+		// the running total behind copied_bytes().
+		static std::atomic<unsigned long long int> & copy_counter();
 	protected:
 	public:
+		/** What has happened to the genes since mark_clean() was last 
+		 ** called; see changes().
+		 **/
+		enum change_type { unchanged = 0, one_gene = 1, rebuilt = 2 };
 	
 		/// Parent for all basic_chromosome exceptions.
 		class general_exception: public std::exception {};
@@ -59,6 +142,10 @@ class basic_chromosome
 		 ** < 0 or greater than length()-1.
 		 **/
 		class index_error: public general_exception {};
+		/** Thrown if a chromosome with a fixed capacity (N above 0) is 
+		 ** asked to hold more than N genes.
+		 **/
+		class capacity_error: public general_exception {};
 		/** Thrown if there is an unexpected error in one of the 
 		 ** recombine() methods.
 		 ** 
@@ -66,9 +153,6 @@ class basic_chromosome
 		 **/
 		class recombine_error: public general_exception {};
 		/** Thrown by rand_index in the case of an unexpected error.
-		 ** 
-		 ** Likely causes include failure to seed the random number generator 
-		 ** (via the srand48() or seed48() calls) prior to it's first call.
 		 **/
 		class rand_index_error: public general_exception {};
 		/** Thrown if there is an unexpected error in one of the mutate() 
@@ -102,16 +186,37 @@ class basic_chromosome
 		basic_chromosome();
 		/** Creates a chromosome with length genes with randomly assigned values.
 		 ** 
-		 ** Behavor is undefined if the srand random number generator is not 
-		 ** initialized (see man srand for more information).
+		 ** The values come from the calling thread's thread_engine().
 		 **/
 		basic_chromosome(unsigned int length);
 		/** Deallocates memory and destructs object.
 		 **/
 		~basic_chromosome();
-		/** Returns the number of genes in this chromosome.
+		/** Copies source's genes and change history (see changes()).
+		 **/
+		basic_chromosome(const basic_chromosome & source);
+		/// Takes over source's genes, leaving source with none.
+		basic_chromosome(basic_chromosome && source) noexcept;
+		/// As the copy constructor; storage already held is reused.
+		basic_chromosome & operator =(const basic_chromosome & source);
+		/// As the move constructor.
+		basic_chromosome & operator =(basic_chromosome && source) noexcept;
+		/** Gene bytes copied between basic_chromosome<G,N> objects so far.
+		 ** Always 0 unless compiled with CHROMOSOME_COUNT_COPIES defined.
+		 **/
+		static unsigned long long int copied_bytes();
+		/** Adds length random genes, drawn from thread_engine().
 		 **/
 		void reload(unsigned int length);
+		/** Adds length random genes drawn from rng, which may be any 
+		 ** UniformRandomBitGenerator with 64 bit results.
+		 **/
+		template <class R> if_engine<R,void> reload(unsigned int length, 
+			R & rng);
+		/// Replaces the genes with the length values starting at genes.
+		void load(const G * genes, unsigned int length);
+		/// Subtracts amount from every gene, wrapping around past 0.
+		void rotate(G amount);
 		/** Loads this gene with new values from two parents using a random
 		 ** crossover point.
 		 ** 
@@ -133,7 +238,10 @@ class basic_chromosome
 		 ** previously exiting genes in this object are replaced with the new 
 		 ** information.
 		 **/
-		void recombine(basic_chromosome<G> &a, basic_chromosome<G> &b);
+		void recombine(basic_chromosome<G,N> &a, basic_chromosome<G,N> &b);
+		/// recombine(a,b) with the crossover point drawn from rng.
+		template <class R> if_engine<R,void> recombine(
+			basic_chromosome<G,N> &a, basic_chromosome<G,N> &b, R & rng);
 		/** Loads this gene with new values from two parents using a supplied
 		 ** crossover point.
 		 ** 
@@ -145,7 +253,7 @@ class basic_chromosome
 		 ** If crossover is out of bounds for the a or b chromosome a 
 		 ** recombine_error will be thrown.
 		 **/
-		void recombine(basic_chromosome<G> &a, basic_chromosome<G> &b,
+		void recombine(basic_chromosome<G,N> &a, basic_chromosome<G,N> &b,
 			unsigned int crossover);
 		/** Loads this chromosome with the result of splicing parent chromosomes.
 		 ** 
@@ -160,7 +268,10 @@ class basic_chromosome
 		 ** This version of splice() determines the section spliced randomly
 		 ** and preserves the length of the a chromosome in the child.
 		 **/
-		void splice(basic_chromosome<G> &a, basic_chromosome<G> &b);
+		void splice(basic_chromosome<G,N> &a, basic_chromosome<G,N> &b);
+		/// splice(a,b) with the section drawn from rng.
+		template <class R> if_engine<R,void> splice(
+			basic_chromosome<G,N> &a, basic_chromosome<G,N> &b, R & rng);
 		/** Loads this chromosome with the result of a user defined splice 
 		 ** of two parents.
 		 ** 
@@ -175,8 +286,37 @@ class basic_chromosome
 		 ** 
 		 ** This method does the actual work for all the splicing methods.
 		 **/
-		void splice(basic_chromosome<G> &a, basic_chromosome<G> &b, 
+		void splice(basic_chromosome<G,N> &a, basic_chromosome<G,N> &b, 
 			unsigned int begin, unsigned int end);
+		/** Loads this chromosome with each gene taken from a or b as 
+		 ** mask says: gene i comes from b if bit i % 64 of mask[i / 64] 
+		 ** is set, else from a. Requires both chromosomes be the same 
+		 ** length; a recombine_error is thrown if they are not.
+		 **/
+		void masked_crossover(basic_chromosome<G,N> &a, 
+			basic_chromosome<G,N> &b, const uint64_t * mask);
+		/** Uniform crossover: a masked_crossover() with a random mask, 
+		 ** so each gene comes from a or b with even odds.
+		 **/
+		void uniform_crossover(basic_chromosome<G,N> &a, 
+			basic_chromosome<G,N> &b);
+		/// uniform_crossover() with the mask drawn from rng.
+		template <class R> if_engine<R,void> uniform_crossover(
+			basic_chromosome<G,N> &a, basic_chromosome<G,N> &b, R & rng);
+		/** Loads this chromosome with a's genes, switching parent at each
+		 ** of the count points, which must be ascending and no more than 
+		 ** the length. Requires both chromosomes be the same length; a 
+		 ** recombine_error is thrown otherwise.
+		 **/
+		void multipoint_crossover(basic_chromosome<G,N> &a, 
+			basic_chromosome<G,N> &b, const unsigned int * points, 
+			unsigned int count);
+		/** multipoint_crossover() at count points drawn from rng, up
+		 ** to max_crossover_points.
+		 **/
+		template <class R> if_engine<R,void> multipoint_crossover(
+			basic_chromosome<G,N> &a, basic_chromosome<G,N> &b, 
+			unsigned int count, R & rng);
 		/** Mutates one randomly selected gene randomly.
 		 ** 
 		 ** A randomly selected gene in this chromosome is changed to new randomly
@@ -186,6 +326,8 @@ class basic_chromosome
 		 ** random mutations.... ;)
 		 **/
 		int mutate();
+		/// mutate() with the gene and its new value drawn from rng.
+		template <class R> if_engine<R,int> mutate(R & rng);
 		/** Randomly mutates the selected gene.
 		 ** 
 		 ** The gene at index which is loaded with a new, randomly selected value.
@@ -197,6 +339,9 @@ class basic_chromosome
 		 ** thrown.
 		 **/
 		int mutate(unsigned int which);
+		/// mutate(which) with the new value drawn from rng.
+		template <class R> if_engine<R,int> mutate(unsigned int which, 
+			R & rng);
 		/** Sets the selected gene to the selected  value.
 		 ** 
 		 ** The gene at index which is loaded with the value supplied. This method 
@@ -243,84 +388,236 @@ class basic_chromosome
 		 ** just to see it. Use the mutate() methods to change the value.
 		 **/
 		const G& operator [](unsigned int index);	
+		/** Gene access without the bounds check; index must be below 
+		 ** size(). Checked anyway when compiled with CHROMOSOME_DEBUG.
+		 **/
+		inline const G & at_unchecked(unsigned int index) const
+		{
+#ifdef CHROMOSOME_DEBUG
+			return const_cast<basic_chromosome<G,N> &>(*this)[index];
+#else
+			return genlist.data()[index];
+#endif
+		};
+		/** The genes, size() of them in a row, for reading in bulk. 
+		 ** Valid until the chromosome is next changed.
+		 **/
+		inline const G * data() const { return genlist.data(); };
+		/// Number of genes; the same as length().
+		inline unsigned int size() const { return genlist.size(); };
+		/// Start and end of data(), for the standard algorithms.
+		inline const G * begin() const { return genlist.data(); };
+		inline const G * end() const 
+		{ 
+			return genlist.data() + genlist.size(); 
+		};
 		/** Returns a valid random gene index.
 		 ** 
 		 ** The returned value will be between 0 and length()-1, inclusive.
 		 **/
 		unsigned int rand_index();
+		/// rand_index() drawn from rng.
+		template <class R> if_engine<R,unsigned int> rand_index(R & rng);
+		/** Reports how the genes have changed since mark_clean(): not at 
+		 ** all, by exactly one mutate() (see last_mutation_index()), or 
+		 ** rebuilt in any other way. A new chromosome starts out rebuilt.
+		 **/
+		change_type changes();
+		/// Records that any results derived from the genes are up to date.
+		void mark_clean();
+		/// Index of the gene changed by the most recent mutate(), or -1.
+		int last_mutation_index();
+		/// Value stored by the most recent mutate().
+		int last_mutation_value();
+		/// Value the most recent mutate() overwrote.
+		G replaced_gene();
 };
 
 // definition starts below
 
-template <class G> unsigned int basic_chromosome<G>::rand_index()
+template <class G, unsigned int N> unsigned int basic_chromosome<G,N>::rand_index()
 {
-	try
-	{
-		long double working = drand48();
-		working *= genlist.size();
-		return (int) floor(working);
-	}
-	catch (...)
-	{
-		std::cerr << "\n" << __FILE__ << ":" << __FUNCTION__
-			<< ": Unexpected error." << std::endl;
-		throw rand_index_error();
-	};
+	return rand_index(thread_engine());
 };
 
-template <class G> basic_chromosome<G>::basic_chromosome()
+template <class G, unsigned int N> template <class R> 
+	if_engine<R,unsigned int> basic_chromosome<G,N>::rand_index(R & rng)
+{
+	// an empty chromosome gets 0, as it always has.
+	if (genlist.size() == 0) return 0;
+	return below(rng, genlist.size());
+};
+
+template <class G, unsigned int N> basic_chromosome<G,N>::basic_chromosome()
 {
 	genlist.clear();
 	mutation_index = -1;
 	mutation_value = 0;
+	change_state = rebuilt;
+	replaced_value = 0;
 };
 
-template <class G> basic_chromosome<G>::basic_chromosome(unsigned int length)
+template <class G, unsigned int N> basic_chromosome<G,N>::basic_chromosome(unsigned int length)
 {
 	reload(length);
 };
 
-template <class G> basic_chromosome<G>::~basic_chromosome()
+template <class G, unsigned int N> basic_chromosome<G,N>::~basic_chromosome()
 {
 	genlist.clear();
 };
 
-template <class G> void basic_chromosome<G>::reload(unsigned int length)
+template <class G, unsigned int N> 
+std::atomic<unsigned long long int> & basic_chromosome<G,N>::copy_counter()
+{
+	static std::atomic<unsigned long long int> returnme(0);
+	return returnme;
+};
+
+template <class G, unsigned int N> 
+basic_chromosome<G,N>::basic_chromosome(const basic_chromosome & source)
+	: genlist(source.genlist)
+{
+	mutation_index = source.mutation_index;
+	mutation_value = source.mutation_value;
+	change_state = source.change_state;
+	replaced_value = source.replaced_value;
+#ifdef CHROMOSOME_COUNT_COPIES
+	copy_counter().fetch_add(genlist.size() * sizeof(G), 
+		std::memory_order_relaxed);
+#endif
+};
+
+template <class G, unsigned int N> 
+basic_chromosome<G,N>::basic_chromosome(basic_chromosome && source) noexcept
+	: genlist(std::move(source.genlist))
+{
+	mutation_index = source.mutation_index;
+	mutation_value = source.mutation_value;
+	change_state = source.change_state;
+	replaced_value = source.replaced_value;
+#ifdef CHROMOSOME_COUNT_COPIES
+	if (N) copy_counter().fetch_add(genlist.size() * sizeof(G), 
+		std::memory_order_relaxed);
+#endif
+	source.genlist.clear();
+	source.mutation_index = -1;
+	source.change_state = rebuilt;
+};
+
+template <class G, unsigned int N> basic_chromosome<G,N> & 
+	basic_chromosome<G,N>::operator =(const basic_chromosome & source)
+{
+	if (this == &source) return *this;
+	genlist = source.genlist;
+	mutation_index = source.mutation_index;
+	mutation_value = source.mutation_value;
+	change_state = source.change_state;
+	replaced_value = source.replaced_value;
+#ifdef CHROMOSOME_COUNT_COPIES
+	copy_counter().fetch_add(genlist.size() * sizeof(G), 
+		std::memory_order_relaxed);
+#endif
+	return *this;
+};
+
+template <class G, unsigned int N> basic_chromosome<G,N> & 
+	basic_chromosome<G,N>::operator =(basic_chromosome && source) noexcept
+{
+	if (this == &source) return *this;
+	genlist = std::move(source.genlist);
+	mutation_index = source.mutation_index;
+	mutation_value = source.mutation_value;
+	change_state = source.change_state;
+	replaced_value = source.replaced_value;
+#ifdef CHROMOSOME_COUNT_COPIES
+	if (N) copy_counter().fetch_add(genlist.size() * sizeof(G), 
+		std::memory_order_relaxed);
+#endif
+	source.genlist.clear();
+	source.mutation_index = -1;
+	source.change_state = rebuilt;
+	return *this;
+};
+
+template <class G, unsigned int N> 
+unsigned long long int basic_chromosome<G,N>::copied_bytes()
+{
+	return copy_counter().load(std::memory_order_relaxed);
+};
+
+template <class G, unsigned int N> void basic_chromosome<G,N>::reload(unsigned int length)
+{
+	reload(length, thread_engine());
+};
+
+template <class G, unsigned int N> template <class R> 
+	if_engine<R,void> basic_chromosome<G,N>::reload(unsigned int length, 
+	R & rng)
 {
 	mutation_index = -1;
 	mutation_value = 0;	
+	change_state = rebuilt;
+	replaced_value = 0;
 	for (unsigned int i=0; i < length; i++)
 	{
-		genlist.push_back(lrand48());
+		genlist.push_back((G) (rng() >> 32));
 	};	
 };
 
-template <class G> void basic_chromosome<G>::recombine(basic_chromosome<G> &a, 
-	basic_chromosome<G> &b)
+template <class G, unsigned int N> void basic_chromosome<G,N>::load(const G * genes, 
+	unsigned int length)
+{
+	mutation_index = -1;
+	mutation_value = 0;	
+	change_state = rebuilt;
+	replaced_value = 0;
+	genlist.assign(genes, genes + length);
+};
+
+template <class G, unsigned int N> void basic_chromosome<G,N>::rotate(G amount)
+{
+	mutation_index = -1;
+	mutation_value = 0;	
+	change_state = rebuilt;
+	replaced_value = 0;
+	for (unsigned int i=0; i < genlist.size(); i++)
+	{
+		genlist[i] = (G) (genlist[i] - amount);
+	};
+};
+
+template <class G, unsigned int N> void basic_chromosome<G,N>::recombine(basic_chromosome<G,N> &a, 
+	basic_chromosome<G,N> &b)
+{
+	recombine(a,b,thread_engine());
+};
+
+template <class G, unsigned int N> template <class R> 
+	if_engine<R,void> basic_chromosome<G,N>::recombine(
+	basic_chromosome<G,N> &a, basic_chromosome<G,N> &b, R & rng)
 {
 	// get a random location for the cross-over
-	recombine(a,b,a.rand_index());
+	recombine(a,b,a.rand_index(rng));
 };
 
-template <class G> void basic_chromosome<G>::recombine(basic_chromosome<G> &a, 
-	basic_chromosome<G> &b, unsigned int crossover)
+template <class G, unsigned int N> void basic_chromosome<G,N>::recombine(basic_chromosome<G,N> &a, 
+	basic_chromosome<G,N> &b, unsigned int crossover)
 {
 	try
 	{
 		if ((a.length() > crossover) && (b.length() > crossover))
 		{
-			// clear our the current genlist contents
-			genlist.clear();
-			// move the first part of a to our genlist
-			for (unsigned int i = 0; i < crossover; i++)
-			{
-				genlist.push_back(a[i]);
-			};
-			// move the second part of b to our genlist
-			for (unsigned int i = crossover; i < b.length(); i++)
-			{
-				genlist.push_back(b[i]);
-			};
+			change_state = rebuilt;
+			/* the child takes b's length; a's part stays put if a is 
+			 * this chromosome, as does b's.
+			 */
+			genlist.resize(b.genlist.size());
+			// the first part of a, then the second part of b.
+			std::copy(a.genlist.begin(), a.genlist.begin() + crossover,
+				genlist.begin());
+			std::copy(b.genlist.begin() + crossover, b.genlist.end(),
+				genlist.begin() + crossover);
 		}
 		else 
 		{
@@ -340,45 +637,60 @@ template <class G> void basic_chromosome<G>::recombine(basic_chromosome<G> &a,
 
 // new section
 
-template <class G> void basic_chromosome<G>::splice(basic_chromosome<G> &a, 
-	basic_chromosome<G> &b)
+template <class G, unsigned int N> void basic_chromosome<G,N>::splice(basic_chromosome<G,N> &a, 
+	basic_chromosome<G,N> &b)
+{
+	splice(a,b,thread_engine());
+};
+
+template <class G, unsigned int N> template <class R> 
+	if_engine<R,void> basic_chromosome<G,N>::splice(
+	basic_chromosome<G,N> &a, basic_chromosome<G,N> &b, R & rng)
 {
 	// get a random location for the start and end.
-	splice(a,b,a.rand_index(),a.rand_index());
+	unsigned int start = a.rand_index(rng);
+	splice(a,b,start,a.rand_index(rng));
 };
 
-template <class G> void basic_chromosome<G>::splice(basic_chromosome<G> &a, 
-	basic_chromosome<G> &b, unsigned int start, unsigned int end)
+template <class G, unsigned int N> void basic_chromosome<G,N>::splice(basic_chromosome<G,N> &a, 
+	basic_chromosome<G,N> &b, unsigned int start, unsigned int end)
 {
 	// only proceed if both start and end are in bounds...
 	if ((start >= 0) && (start < a.length())
 	  && (end >= 0) && (end < a.length())
 	  && (a.length() == b.length()))
 	{
+		// b's section would be overwritten as it was read.
+		if (&b == this)
+		{
+			basic_chromosome<G,N> copy(b);
+			splice(a,copy,start,end);
+			return;
+		};
 		// do the splice.
 		try
 		{
-			genlist.clear();
+			change_state = rebuilt;
+			genlist.resize(a.genlist.size());
 			// which way are we going?
 			bool reverse = start > end;
 			unsigned int astart = std::min(start,end);
 			unsigned int aend = std::max(start,end);
-			unsigned int diff = aend - astart;
-			// load the first part of our chromosome.
-			for (unsigned int i=0; i < astart; i++)
-			{
-				genlist.push_back(a[i]);
-			};
-			// load the second.
-			for (unsigned int i=0; i <= diff; i++)
+			G * to = genlist.data();
+			const G * from_a = a.genlist.data();
+			const G * from_b = b.genlist.data();
+			// the first and last parts of our chromosome.
+			std::copy(from_a, from_a + astart, to);
+			std::copy(from_a + aend + 1, from_a + a.length(), to + aend + 1);
+			// and the section between.
+			if (reverse)
 			{
-				int work_i = reverse ? (aend - i) : (astart+i);
-				genlist.push_back(b[work_i]);
-			};
-			// load the last section.
-			for (unsigned int i = aend+1; i < a.length(); i++)
+				std::reverse_copy(from_b + astart, from_b + aend + 1, 
+					to + astart);
+			}
+			else
 			{
-				genlist.push_back(a[i]);
+				std::copy(from_b + astart, from_b + aend + 1, to + astart);
 			};
 		}
 		catch (...)
@@ -391,15 +703,6 @@ template <class G> void basic_chromosome<G>::splice(basic_chromosome<G> &a,
 				<< ")" << std::endl; 
 			throw splice_error();
 		};
-		if (a.length() != length())
-		{
-			std::cerr << "\n" << __FILE__ << ":" << __FUNCTION__
-				<< ": child/parent length mismatch\n\t"
-				<< "(parent length=" << a.length()
-				<< " child length=" << length()
-				<< ")" << std::endl;
-			throw splice_error();
-		};
 	}
 	else
 	{
@@ -416,22 +719,129 @@ template <class G> void basic_chromosome<G>::splice(basic_chromosome<G> &a,
 
 // end new section
 
-template <class G> int basic_chromosome<G>::mutate()
+template <class G, unsigned int N> void basic_chromosome<G,N>::masked_crossover(
+	basic_chromosome<G,N> &a, basic_chromosome<G,N> &b, const uint64_t * mask)
+{
+	if (a.length() != b.length())
+	{
+		std::cerr << "\n" << __FILE__ << ":" << __FUNCTION__ 
+			<< ": Errored\n\t(a.length=" << a.length() 
+			<< ", b.length=" << b.length()
+			<< ")" << std::endl; 
+		throw recombine_error();
+	};
+	change_state = rebuilt;
+	genlist.resize(a.genlist.size());
+	blend_genes(a.genlist.data(), b.genlist.data(), mask, genlist.data(),
+		genlist.size());
+};
+
+template <class G, unsigned int N> void basic_chromosome<G,N>::uniform_crossover(
+	basic_chromosome<G,N> &a, basic_chromosome<G,N> &b)
+{
+	uniform_crossover(a,b,thread_engine());
+};
+
+template <class G, unsigned int N> template <class R> 
+	if_engine<R,void> basic_chromosome<G,N>::uniform_crossover(
+	basic_chromosome<G,N> &a, basic_chromosome<G,N> &b, R & rng)
+{
+	if (a.length() != b.length())
+	{
+		std::cerr << "\n" << __FILE__ << ":" << __FUNCTION__ 
+			<< ": Errored\n\t(a.length=" << a.length() 
+			<< ", b.length=" << b.length()
+			<< ")" << std::endl; 
+		throw recombine_error();
+	};
+	change_state = rebuilt;
+	genlist.resize(a.genlist.size());
+	uniform_genes(a.genlist.data(), b.genlist.data(), genlist.data(),
+		genlist.size(), rng);
+};
+
+template <class G, unsigned int N> void basic_chromosome<G,N>::multipoint_crossover(
+	basic_chromosome<G,N> &a, basic_chromosome<G,N> &b, 
+	const unsigned int * points, unsigned int count)
+{
+	unsigned int n = a.length();
+	bool ordered = true;
+	for (unsigned int i=0; i < count; i++)
+	{
+		if ((points[i] > n) || (i && (points[i] < points[i-1]))) 
+		{
+			ordered = false;
+		};
+	};
+	if (!ordered || (b.length() != n))
+	{
+		std::cerr << "\n" << __FILE__ << ":" << __FUNCTION__ 
+			<< ": Errored\n\t(a.length=" << a.length() 
+			<< ", b.length=" << b.length()
+			<< ", points=";
+		for (unsigned int i=0; i < count; i++)
+		{
+			std::cerr << (i ? "," : "") << points[i];
+		};
+		std::cerr << ")" << std::endl; 
+		throw recombine_error();
+	};
+	change_state = rebuilt;
+	genlist.resize(n);
+	multipoint_genes(a.genlist.data(), b.genlist.data(), points, count,
+		genlist.data(), n);
+};
+
+template <class G, unsigned int N> template <class R> 
+	if_engine<R,void> basic_chromosome<G,N>::multipoint_crossover(
+	basic_chromosome<G,N> &a, basic_chromosome<G,N> &b, unsigned int count,
+	R & rng)
 {
-	G value = lrand48();
-	return mutate(rand_index(),value);
+	unsigned int points[max_crossover_points];
+	if (count > max_crossover_points)
+	{
+		std::cerr << "\n" << __FILE__ << ":" << __FUNCTION__ 
+			<< ": Errored\n\t(count=" << count 
+			<< ", max_points=" << max_crossover_points
+			<< ")" << std::endl; 
+		throw recombine_error();
+	};
+	draw_points(rng, a.length(), points, count);
+	multipoint_crossover(a, b, points, count);
 };
 
-template <class G> int basic_chromosome<G>::mutate(unsigned int which)
+template <class G, unsigned int N> int basic_chromosome<G,N>::mutate()
 {
-	G value = lrand48();
+	return mutate(thread_engine());
+};
+
+template <class G, unsigned int N> template <class R> 
+	if_engine<R,int> basic_chromosome<G,N>::mutate(R & rng)
+{
+	unsigned int which = rand_index(rng);
+	return mutate(which, rng);
+};
+
+template <class G, unsigned int N> int basic_chromosome<G,N>::mutate(unsigned int which)
+{
+	return mutate(which, thread_engine());
+};
+
+template <class G, unsigned int N> template <class R> 
+	if_engine<R,int> basic_chromosome<G,N>::mutate(unsigned int which, 
+	R & rng)
+{
+	G value = rng() >> 32;
 	return mutate(which, value);
 };
 
-template <class G> int basic_chromosome<G>::mutate(unsigned int which, G value)
+template <class G, unsigned int N> int basic_chromosome<G,N>::mutate(unsigned int which, G value)
 {
 	if (which < genlist.size())
 	{
+		// a second change is more than one_gene can describe.
+		change_state = (change_state == unchanged) ? one_gene : rebuilt;
+		replaced_value = genlist[which];
 		genlist[which] = value;
 		mutation_index = which;
 		mutation_value = value;
@@ -447,7 +857,7 @@ template <class G> int basic_chromosome<G>::mutate(unsigned int which, G value)
 	return which;
 };
 
-template <class G> std::string basic_chromosome<G>::enstream()
+template <class G, unsigned int N> std::string basic_chromosome<G,N>::enstream()
 {
 	try
 	{
@@ -469,10 +879,11 @@ template <class G> std::string basic_chromosome<G>::enstream()
 	};
 };
 
-template <class G> void basic_chromosome<G>::destream(std::string source)
+template <class G, unsigned int N> void basic_chromosome<G,N>::destream(std::string source)
 {
 	try
 	{
+		change_state = rebuilt;
 		genlist.clear();
 		while (source.length())
 		{
@@ -501,12 +912,12 @@ template <class G> void basic_chromosome<G>::destream(std::string source)
 	};
 };
 
-template <class G> unsigned int basic_chromosome<G>::length()
+template <class G, unsigned int N> unsigned int basic_chromosome<G,N>::length()
 {
 	return genlist.size();
 };
 
-template <class G> const G& basic_chromosome<G>::operator [](unsigned int index) 
+template <class G, unsigned int N> const G& basic_chromosome<G,N>::operator [](unsigned int index) 
 {
 	if (index < genlist.size())
 	{
@@ -522,6 +933,32 @@ template <class G> const G& basic_chromosome<G>::operator [](unsigned int index)
 	};
 };
 
+template <class G, unsigned int N> typename basic_chromosome<G,N>::change_type 
+	basic_chromosome<G,N>::changes()
+{
+	return (change_type) change_state;
+};
+
+template <class G, unsigned int N> void basic_chromosome<G,N>::mark_clean()
+{
+	change_state = unchanged;
+};
+
+template <class G, unsigned int N> int basic_chromosome<G,N>::last_mutation_index()
+{
+	return mutation_index;
+};
+
+template <class G, unsigned int N> int basic_chromosome<G,N>::last_mutation_value()
+{
+	return mutation_value;
+};
+
+template <class G, unsigned int N> G basic_chromosome<G,N>::replaced_gene()
+{
+	return replaced_value;
+};
+
 }// namespace ricklib
 
 #endif
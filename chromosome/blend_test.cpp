@@ -0,0 +1,292 @@
+/***********************************************
+This file is part of the Rick's Generic GA Solver project (https://launchpad.net/ricks-ga).
+
+    Rick's Generic GA Solver is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Rick's Generic GA Solver is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Rick's Generic GA Solver.  If not, see <http://www.gnu.org/licenses/>.
+
+***********************************************/
+// masked, uniform and multi-point crossover test and timing program
+
+#include "basic_chromosome.h"
+#include "gene_arena.h"
+#include <stdlib.h>
+#include <sys/time.h>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+
+using namespace std;
+using ricks_ga::blend_kernel;
+
+const blend_kernel kernels[] = {ricks_ga::scalar_blend, 
+	ricks_ga::avx2_blend, ricks_ga::avx512_blend};
+const char * kernel_names[] = {"scalar", "avx2", "avx512"};
+
+double now()
+{
+	timeval t;
+	gettimeofday(&t,0);
+	return t.tv_sec + t.tv_usec / 1e6;
+};
+
+// reference: gene by gene.
+template <class G>
+void reference_blend(const vector<G> & a, const vector<G> & b, 
+	const vector<uint64_t> & mask, vector<G> & out)
+{
+	out.resize(a.size());
+	for (unsigned int i=0; i < a.size(); i++)
+	{
+		out[i] = (mask[i / 64] & (1ULL << (i % 64))) ? b[i] : a[i];
+	};
+};
+
+template <class G>
+void reference_points(const vector<G> & a, const vector<G> & b,
+	const vector<unsigned int> & points, vector<G> & out)
+{
+	out.resize(a.size());
+	for (unsigned int i=0; i < a.size(); i++)
+	{
+		unsigned int passed = 0;
+		for (unsigned int p=0; p < points.size(); p++)
+		{
+			if (points[p] <= i) passed++;
+		};
+		out[i] = (passed % 2) ? b[i] : a[i];
+	};
+};
+
+template <class G>
+vector<G> random_genes(unsigned int n)
+{
+	vector<G> returnme(n);
+	for (unsigned int i=0; i < n; i++) returnme[i] = mrand48();
+	return returnme;
+};
+
+// every kernel, every length around the vector widths, in place too.
+template <class G>
+int check_blend()
+{
+	int errors = 0;
+	for (unsigned int n=0; n < 300; n += (n < 140) ? 1 : 37)
+	{
+		vector<G> a = random_genes<G>(n), b = random_genes<G>(n);
+		vector<uint64_t> mask((n + 63) / 64 + 1);
+		for (unsigned int w=0; w < mask.size(); w++) 
+		{
+			mask[w] = ((uint64_t) mrand48() << 32) ^ mrand48();
+		};
+		vector<G> want;
+		reference_blend(a, b, mask, want);
+		for (int k=0; k < 3; k++)
+		{
+			vector<G> out(n), in_place(a);
+			ricks_ga::blend_genes(a.data(), b.data(), mask.data(), out.data(),
+				n, kernels[k]);
+			ricks_ga::blend_genes(in_place.data(), b.data(), mask.data(), 
+				in_place.data(), n, kernels[k]);
+			if ((out != want) || (in_place != want))
+			{
+				cerr << kernel_names[k] << " blend of " << sizeof(G) 
+					<< " byte genes wrong at n=" << n << endl;
+				errors++;
+			};
+		};
+	};
+	return errors;
+};
+
+template <class C, class G>
+vector<G> genes(C & c)
+{
+	return vector<G>(c.begin(), c.end());
+};
+
+// the chromosome and arena versions against the references.
+template <class G>
+int check_crossovers()
+{
+	typedef ricks_ga::basic_chromosome<G> chromosome;
+	typedef ricks_ga::gene_arena<G> arena;
+	int errors = 0;
+	unsigned int sizes[] = {1,2,3,7,50,1000,5000};
+	for (unsigned int s=0; s < sizeof(sizes)/sizeof(int); s++)
+	{
+		unsigned int n = sizes[s];
+		chromosome a, b, child;
+		a.reload(n);
+		b.reload(n);
+		child.reload(n / 2 + 1);
+		arena rows;
+		rows.reserve(3, n);
+		rows.add().load(a.data());
+		rows.add().load(b.data());
+		rows.add();
+		vector<G> ga = genes<chromosome,G>(a), gb = genes<chromosome,G>(b);
+		vector<G> want;
+		for (unsigned int t=0; t < 50; t++)
+		{
+			// masked, then uniform from engines seeded alike.
+			vector<uint64_t> mask((n + 63) / 64);
+			for (unsigned int w=0; w < mask.size(); w++) 
+			{
+				mask[w] = ((uint64_t) mrand48() << 32) ^ mrand48();
+			};
+			reference_blend(ga, gb, mask, want);
+			child.masked_crossover(a, b, mask.data());
+			rows[2].masked_crossover(rows[0], rows[1], mask.data());
+			if ((genes<chromosome,G>(child) != want) 
+				|| (vector<G>(rows[2].data(), rows[2].data() + n) != want))
+			{
+				cerr << "masked crossover mismatch at n=" << n << endl;
+				errors++;
+			};
+			ricks_ga::xoshiro256ss r1(t), r2(t), r3(t);
+			for (unsigned int w=0; w < mask.size(); w++) mask[w] = r1();
+			reference_blend(ga, gb, mask, want);
+			child.uniform_crossover(a, b, r2);
+			rows[2].uniform_crossover(rows[0], rows[1], r3);
+			if ((genes<chromosome,G>(child) != want) 
+				|| (vector<G>(rows[2].data(), rows[2].data() + n) != want))
+			{
+				cerr << "uniform crossover mismatch at n=" << n << endl;
+				errors++;
+			};
+			// points at random, including repeats, 0 and n.
+			unsigned int count = lrand48() % 6;
+			vector<unsigned int> points(count);
+			for (unsigned int p=0; p < count; p++) 
+			{
+				points[p] = lrand48() % (n + 1);
+			};
+			sort(points.begin(), points.end());
+			reference_points(ga, gb, points, want);
+			child.multipoint_crossover(a, b, points.data(), count);
+			rows[2].multipoint_crossover(rows[0], rows[1], points.data(), 
+				count);
+			if ((genes<chromosome,G>(child) != want)
+				|| (vector<G>(rows[2].data(), rows[2].data() + n) != want))
+			{
+				cerr << "multipoint crossover mismatch at n=" << n << endl;
+				errors++;
+			};
+			ricks_ga::xoshiro256ss r4(t), r5(t);
+			chromosome drawn, c(a);
+			drawn.multipoint_crossover(a, b, 3, r4);
+			rows[2].multipoint_crossover(rows[0], rows[1], 3, r5);
+			if (vector<G>(rows[2].data(), rows[2].data() + n) 
+				!= genes<chromosome,G>(drawn))
+			{
+				errors++;
+			};
+			// a parent may be the child.
+			c.multipoint_crossover(c, b, points.data(), count);
+			if (genes<chromosome,G>(c) != want) errors++;
+			c = b;
+			c.multipoint_crossover(a, c, points.data(), count);
+			if (genes<chromosome,G>(c) != want) errors++;
+		};
+		// points out of order or bounds, mismatched lengths and too 
+		// many points are refused.
+		chromosome shorter;
+		shorter.reload(n + 1);
+		unsigned int bad[][2] = {{1,0},{0,n+1}};
+		for (int i=0; i < 2; i++)
+		{
+			try
+			{
+				child.multipoint_crossover(a, b, bad[i], 2);
+				errors++;
+			}
+			catch (typename chromosome::recombine_error & e) {};
+		};
+		uint64_t mask[128];
+		try
+		{
+			child.masked_crossover(a, shorter, mask);
+			errors++;
+		}
+		catch (typename chromosome::recombine_error & e) {};
+		try
+		{
+			child.uniform_crossover(a, shorter);
+			errors++;
+		}
+		catch (typename chromosome::recombine_error & e) {};
+		try
+		{
+			child.multipoint_crossover(a, b, 65, ricks_ga::thread_engine());
+			errors++;
+		}
+		catch (typename chromosome::recombine_error & e) {};
+	};
+	return errors;
+};
+
+// ns per child for n genes, blended by each kernel from a fixed mask.
+template <class G>
+void timing(unsigned int n)
+{
+	vector<G> a = random_genes<G>(n), b = random_genes<G>(n), out(n);
+	vector<uint64_t> mask((n + 63) / 64);
+	for (unsigned int w=0; w < mask.size(); w++) mask[w] = mrand48();
+	unsigned int reps = 100000000 / n;
+	double base = 0;
+	unsigned long long int sink = 0;
+	for (int k=0; k < 3; k++)
+	{
+		if (kernels[k] > ricks_ga::best_blend()) break;
+		double start = now();
+		for (unsigned int r=0; r < reps; r++)
+		{
+			mask[r % mask.size()] ^= r;
+			ricks_ga::blend_genes(a.data(), b.data(), mask.data(), out.data(),
+				n, kernels[k]);
+			sink += out[r % n];
+		};
+		double ns = (now() - start) * 1e9 / reps;
+		if (k == 0) base = ns;
+		cout << setw(8) << sizeof(G) << setw(8) << n 
+			<< setw(10) << kernel_names[k]
+			<< setw(14) << fixed << setprecision(1) << ns
+			<< setw(10) << setprecision(2) << base / ns << "x"
+			<< (sink == 1 ? " " : "") << endl;
+	};
+};
+
+int main(int argc, char* argv[])
+{
+	srand48(1);
+	int errors = check_blend<unsigned char>() + check_blend<unsigned short>()
+		+ check_blend<unsigned int>() + check_blend<unsigned long long>()
+		+ check_crossovers<unsigned char>() 
+		+ check_crossovers<unsigned short>()
+		+ check_crossovers<unsigned int>();
+	cout << "masked/uniform/multipoint check: " 
+		<< (errors ? "FAILED" : "passed") << endl;
+	if (argc > 1)
+	{
+		cout << setw(8) << "bytes" << setw(8) << "n" << setw(10) << "kernel"
+			<< setw(14) << "ns per child" << setw(11) << "speedup" << endl;
+		unsigned int sizes[] = {50, 1000, 100000};
+		for (int s=0; s < 3; s++)
+		{
+			timing<unsigned char>(sizes[s]);
+			timing<unsigned short>(sizes[s]);
+			timing<unsigned int>(sizes[s]);
+		};
+	};
+	return errors;
+};
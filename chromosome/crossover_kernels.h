@@ -0,0 +1,285 @@
+/***********************************************
+This file is part of the Rick's Generic GA Solver project (https://launchpad.net/ricks-ga).
+
+    Rick's Generic GA Solver is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Rick's Generic GA Solver is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Rick's Generic GA Solver.  If not, see <http://www.gnu.org/licenses/>.
+
+***********************************************/
+/* crossover_kernels.h - gene blending kernels for the masked and 
+	uniform crossovers.
+*/
+
+#ifndef crossover_kernels_h
+#define crossover_kernels_h
+
+#include <stdint.h>
+#include <algorithm>
+#include <immintrin.h>
+#include "random_engine.h"
+
+namespace ricks_ga
+{
+
+/// The versions of blend_genes(); each gives the same results.
+enum blend_kernel { scalar_blend, avx2_blend, avx512_blend };
+
+/// The fastest blend_genes() version this CPU can run.
+inline blend_kernel best_blend()
+{
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx512f") 
+		&& __builtin_cpu_supports("avx512bw")) return avx512_blend;
+	if (__builtin_cpu_supports("avx2")) return avx2_blend;
+	return scalar_blend;
+};
+
+namespace blend
+{
+
+// without branches, which a random mask would mispredict half the time.
+template <class G>
+inline void scalar(const G * a, const G * b, const uint64_t * mask, G * out,
+	unsigned int first, unsigned int n)
+{
+	unsigned int i = first;
+	while (i < n)
+	{
+		uint64_t m = mask[i / 64] >> (i % 64);
+		unsigned int end = std::min(n, (i / 64 + 1) * 64);
+		for (; i < end; i++)
+		{
+			G pick = (G) 0 - (G) (m & 1);
+			m >>= 1;
+			out[i] = a[i] ^ ((a[i] ^ b[i]) & pick);
+		};
+	};
+};
+
+/* AVX2: the mask bits for a register's worth of genes are spread one 
+ * per gene, turned into all ones or all zeros by comparing, and used 
+ * to blend the parents.
+ */
+__attribute__((target("avx2")))
+inline unsigned int avx2(const unsigned char * a, const unsigned char * b, 
+	const uint64_t * mask, unsigned char * out, unsigned int n)
+{
+	// byte k of the register takes mask byte k/8, then bit k%8 of it.
+	const __m256i spread = _mm256_setr_epi8(
+		0,0,0,0,0,0,0,0, 1,1,1,1,1,1,1,1, 
+		2,2,2,2,2,2,2,2, 3,3,3,3,3,3,3,3);
+	const __m256i bits = _mm256_set1_epi64x(0x8040201008040201LL);
+	unsigned int i = 0;
+	for (; i + 32 <= n; i += 32)
+	{
+		uint32_t m = mask[i / 64] >> (i % 64);
+		__m256i s = _mm256_shuffle_epi8(_mm256_set1_epi32(m), spread);
+		s = _mm256_cmpeq_epi8(_mm256_and_si256(s, bits), bits);
+		__m256i from_a = _mm256_loadu_si256((const __m256i *) (a + i));
+		__m256i from_b = _mm256_loadu_si256((const __m256i *) (b + i));
+		_mm256_storeu_si256((__m256i *) (out + i), 
+			_mm256_blendv_epi8(from_a, from_b, s));
+	};
+	return i;
+};
+
+__attribute__((target("avx2")))
+inline unsigned int avx2(const unsigned short * a, const unsigned short * b,
+	const uint64_t * mask, unsigned short * out, unsigned int n)
+{
+	const __m256i bits = _mm256_setr_epi16(1, 2, 4, 8, 16, 32, 64, 128, 
+		256, 512, 1024, 2048, 4096, 8192, 16384, -32768);
+	unsigned int i = 0;
+	for (; i + 16 <= n; i += 16)
+	{
+		uint16_t m = mask[i / 64] >> (i % 64);
+		__m256i s = _mm256_and_si256(_mm256_set1_epi16(m), bits);
+		s = _mm256_cmpeq_epi16(s, bits);
+		__m256i from_a = _mm256_loadu_si256((const __m256i *) (a + i));
+		__m256i from_b = _mm256_loadu_si256((const __m256i *) (b + i));
+		_mm256_storeu_si256((__m256i *) (out + i), 
+			_mm256_blendv_epi8(from_a, from_b, s));
+	};
+	return i;
+};
+
+__attribute__((target("avx2")))
+inline unsigned int avx2(const unsigned int * a, const unsigned int * b,
+	const uint64_t * mask, unsigned int * out, unsigned int n)
+{
+	const __m256i bits = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+	unsigned int i = 0;
+	for (; i + 8 <= n; i += 8)
+	{
+		uint32_t m = (mask[i / 64] >> (i % 64)) & 0xff;
+		__m256i s = _mm256_and_si256(_mm256_set1_epi32(m), bits);
+		s = _mm256_cmpeq_epi32(s, bits);
+		__m256i from_a = _mm256_loadu_si256((const __m256i *) (a + i));
+		__m256i from_b = _mm256_loadu_si256((const __m256i *) (b + i));
+		_mm256_storeu_si256((__m256i *) (out + i), 
+			_mm256_blendv_epi8(from_a, from_b, s));
+	};
+	return i;
+};
+
+/* AVX-512 blends with the mask bits directly, and finishes with a 
+ * masked load and store, so there is no scalar tail.
+ */
+__attribute__((target("avx512f,avx512bw")))
+inline unsigned int avx512(const unsigned char * a, const unsigned char * b,
+	const uint64_t * mask, unsigned char * out, unsigned int n)
+{
+	for (unsigned int i=0; i < n; i += 64)
+	{
+		__mmask64 in = (n - i >= 64) ? ~0ULL : (1ULL << (n - i)) - 1;
+		__m512i from_a = _mm512_maskz_loadu_epi8(in, a + i);
+		__m512i from_b = _mm512_maskz_loadu_epi8(in, b + i);
+		_mm512_mask_storeu_epi8(out + i, in,
+			_mm512_mask_blend_epi8(mask[i / 64], from_a, from_b));
+	};
+	return n;
+};
+
+__attribute__((target("avx512f,avx512bw")))
+inline unsigned int avx512(const unsigned short * a, 
+	const unsigned short * b, const uint64_t * mask, unsigned short * out,
+	unsigned int n)
+{
+	for (unsigned int i=0; i < n; i += 32)
+	{
+		__mmask32 in = (n - i >= 32) ? ~0U : (1U << (n - i)) - 1;
+		__m512i from_a = _mm512_maskz_loadu_epi16(in, a + i);
+		__m512i from_b = _mm512_maskz_loadu_epi16(in, b + i);
+		_mm512_mask_storeu_epi16(out + i, in, _mm512_mask_blend_epi16(
+			(__mmask32) (mask[i / 64] >> (i % 64)), from_a, from_b));
+	};
+	return n;
+};
+
+__attribute__((target("avx512f,avx512bw")))
+inline unsigned int avx512(const unsigned int * a, const unsigned int * b,
+	const uint64_t * mask, unsigned int * out, unsigned int n)
+{
+	for (unsigned int i=0; i < n; i += 16)
+	{
+		__mmask16 in = (n - i >= 16) ? 0xffff : (1U << (n - i)) - 1;
+		__m512i from_a = _mm512_maskz_loadu_epi32(in, a + i);
+		__m512i from_b = _mm512_maskz_loadu_epi32(in, b + i);
+		_mm512_mask_storeu_epi32(out + i, in, _mm512_mask_blend_epi32(
+			(__mmask16) (mask[i / 64] >> (i % 64)), from_a, from_b));
+	};
+	return n;
+};
+
+// other gene types have no vector versions.
+template <class G>
+inline unsigned int avx2(const G *, const G *, const uint64_t *, G *, 
+	unsigned int)
+{
+	return 0;
+};
+
+template <class G>
+inline unsigned int avx512(const G *, const G *, const uint64_t *, G *, 
+	unsigned int)
+{
+	return 0;
+};
+
+} // namespace blend
+
+/** Sets out[i] to b[i] where bit i of mask is set, else to a[i], for 
+ ** the first n genes. Bit i is bit i % 64 of mask[i / 64].
+ ** 
+ ** Genes of 1, 2 and 4 bytes (unsigned char, short or int) are 
+ ** blended a vector at a time with AVX2 or AVX-512, whichever the CPU 
+ ** has best, unless kernel asks for a lesser version; the scalar loop
+ ** does the rest and any other type. out may be a or b.
+ **/
+template <class G>
+void blend_genes(const G * a, const G * b, const uint64_t * mask, G * out,
+	unsigned int n, blend_kernel kernel = avx512_blend)
+{
+	static const blend_kernel best = best_blend();
+	if (kernel > best) kernel = best;
+	unsigned int done = 0;
+	if (kernel == avx512_blend) done = blend::avx512(a, b, mask, out, n);
+	if (kernel == avx2_blend) done = blend::avx2(a, b, mask, out, n);
+	blend::scalar(a, b, mask, out, done, n);
+};
+
+/** Sets out to a's genes before points[0], b's from there to points[1],
+ ** a's again to points[2] and so on, for n genes. The count points 
+ ** must be ascending and no more than n. out may be a or b.
+ **/
+template <class G>
+void multipoint_genes(const G * a, const G * b, const unsigned int * points,
+	unsigned int count, G * out, unsigned int n)
+{
+	unsigned int from = 0;
+	for (unsigned int i=0; i <= count; i++)
+	{
+		unsigned int to = (i < count) ? points[i] : n;
+		const G * parent = (i % 2) ? b : a;
+		if (parent != out) std::copy(parent + from, parent + to, out + from);
+		from = to;
+	};
+};
+
+/** Sets each of the n genes of out to a's or b's with even odds, 
+ ** taking 64 bits from rng for every 64 genes; see blend_genes().
+ **/
+template <class G, class R>
+void uniform_genes(const G * a, const G * b, G * out, unsigned int n,
+	R & rng)
+{
+	// masks for a few thousand genes at a time, kept on the stack.
+	const unsigned int words = 64;
+	uint64_t mask[words];
+	for (unsigned int first=0; first < n; first += words * 64)
+	{
+		unsigned int genes = std::min(n - first, words * 64);
+		for (unsigned int w=0; w < (genes + 63) / 64; w++)
+		{
+			mask[w] = rng();
+		};
+		blend_genes(a + first, b + first, mask, out + first, genes);
+	};
+};
+
+/// Most points the multipoint crossovers will draw for themselves.
+const unsigned int max_crossover_points = 64;
+
+/** Fills points with count gene indexes below length drawn from rng, 
+ ** in ascending order; see multipoint_crossover().
+ **/
+template <class R>
+void draw_points(R & rng, unsigned int length, unsigned int * points, 
+	unsigned int count)
+{
+	for (unsigned int i=0; i < count; i++)
+	{
+		unsigned int p = below(rng, length);
+		// insertion sort; there are only a few points.
+		unsigned int j = i;
+		while ((j > 0) && (points[j-1] > p))
+		{
+			points[j] = points[j-1];
+			j--;
+		};
+		points[j] = p;
+	};
+};
+
+} // namespace ricks_ga
+
+#endif // crossover_kernels_h
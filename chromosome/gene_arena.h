@@ -0,0 +1,484 @@
+/***********************************************
+This file is part of the Rick's Generic GA Solver project (https://launchpad.net/ricks-ga).
+
+    Rick's Generic GA Solver is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Rick's Generic GA Solver is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Rick's Generic GA Solver.  If not, see <http://www.gnu.org/licenses/>.
+
+***********************************************/
+/* gene_arena.h - presents the gene arena template.
+*/
+
+#ifndef gene_arena_h
+#define gene_arena_h
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string>
+#include <algorithm>
+#include <iostream>
+#include "random_engine.h"
+#include "crossover_kernels.h"
+
+namespace ricks_ga
+{
+
+/** A population of chromosomes of a single length, stored as rows of 
+ ** one 64 byte aligned block of genes and handled through views. Only
+ ** reserve() allocates.
+ **/
+template <class G>
+class gene_arena
+{
+	private:
+		G * block;
+		float * fitnesses;
+		unsigned char * changes;
+		unsigned int rows;
+		unsigned int used;
+		unsigned int genes;
+		// genes from one row to the next; rows start 64 bytes apart.
+		unsigned int stride;
+		// an arena owns its block, so it can not be copied.
+		gene_arena(const gene_arena<G> &);
+		gene_arena<G> & operator =(const gene_arena<G> &);
+	public:
+		/// Parent for all gene_arena exceptions.
+		class general_exception: public std::exception {};
+		/// Thrown by add() when every reserved row is in use.
+		class capacity_error: public general_exception {};
+		/// Thrown if a row or gene that does not exist is asked for.
+		class index_error: public general_exception {};
+		/// Thrown by reserve() if the block can not be allocated.
+		class allocation_error: public general_exception {};
+		/// Thrown by view::recombine() on a bad crossover point.
+		class recombine_error: public general_exception {};
+		/// Thrown by view::splice() on a bad start or end.
+		class splice_error: public general_exception {};
+		/// Thrown by view::mutate() on a bad gene index.
+		class mutate_error: public general_exception {};
+
+		/** One chromosome (row) of an arena. Invalid once the arena is
+		 ** reserved again or swapped.
+		 **/
+		class view
+		{
+			private:
+				gene_arena<G> * arena;
+				unsigned int row;
+				G * genes;
+			public:
+				view(gene_arena<G> & a, unsigned int r);
+				/// The row's index in its arena.
+				unsigned int index() { return row; };
+				/// Number of genes, the arena's length().
+				unsigned int length() { return arena->genes; };
+				/// The genes, length() of them.
+				G * data() { return genes; };
+				/// Gene access, with the checks of basic_chromosome's.
+				const G & operator [](unsigned int index);
+				/// The row's entry in the arena's fitness array.
+				float & fitness() { return arena->fitnesses[row]; };
+				/** True if the genes have been changed since 
+				 ** mark_clean(); new rows start out changed.
+				 **/
+				bool changed() { return arena->changes[row] != 0; };
+				/// Records that the fitness is up to date.
+				void mark_clean() { arena->changes[row] = 0; };
+				/// Copies source's genes, fitness and changed state.
+				void copy(view source);
+				/// Loads the length() genes starting at values.
+				void load(const G * values);
+				/// Loads random genes, as basic_chromosome::reload().
+				void reload();
+				/// reload() with the genes drawn from rng.
+				template <class R> if_engine<R,void> reload(R & rng);
+				/** The first crossover genes of a followed by the rest 
+				 ** of b; see basic_chromosome::recombine().
+				 **/
+				void recombine(view a, view b, unsigned int crossover);
+				/** a with the genes from start to end (inclusive) 
+				 ** replaced by b's, reversed if end is less than start;
+				 ** see basic_chromosome::splice().
+				 **/
+				void splice(view a, view b, unsigned int start, 
+					unsigned int end);
+				/// As basic_chromosome::masked_crossover().
+				void masked_crossover(view a, view b, 
+					const uint64_t * mask);
+				/// As basic_chromosome::uniform_crossover().
+				template <class R> if_engine<R,void> uniform_crossover(
+					view a, view b, R & rng);
+				/// As basic_chromosome::multipoint_crossover().
+				void multipoint_crossover(view a, view b, 
+					const unsigned int * points, unsigned int count);
+				/** multipoint_crossover() at count points drawn from 
+				 ** rng, up to max_crossover_points.
+				 **/
+				template <class R> if_engine<R,void> multipoint_crossover(
+					view a, view b, unsigned int count, R & rng);
+				/// Sets the gene at which to value, returning which.
+				int mutate(unsigned int which, G value);
+				/// As basic_chromosome::rotate().
+				void rotate(G amount);
+				/// As basic_chromosome::enstream().
+				std::string enstream();
+		};
+
+		gene_arena();
+		/// An arena already reserved; see reserve().
+		gene_arena(unsigned int rows, unsigned int length);
+		~gene_arena();
+		/** Allocates room for rows chromosomes of length genes each, 
+		 ** discarding any rows already held. The only method that 
+		 ** allocates.
+		 **/
+		void reserve(unsigned int rows, unsigned int length);
+		/// Rows in use.
+		unsigned int size() { return used; };
+		/// Rows reserved.
+		unsigned int capacity() { return rows; };
+		/// Genes per chromosome.
+		unsigned int length() { return genes; };
+		/// Stops using every row; nothing is freed.
+		void clear() { used = 0; };
+		/// Starts using the next row, which holds no genes in particular.
+		view add();
+		/// The row at index, which must be in use.
+		view operator [](unsigned int index);
+		/// Exchanges the contents of this arena and other.
+		void swap(gene_arena<G> & other);
+};
+
+// definition starts below
+
+template <class G> gene_arena<G>::view::view(gene_arena<G> & a, 
+	unsigned int r)
+{
+	arena = &a;
+	row = r;
+	genes = a.block + (size_t) r * a.stride;
+};
+
+template <class G> 
+const G & gene_arena<G>::view::operator [](unsigned int index)
+{
+	if (index < arena->genes)
+	{
+		return genes[index];
+	}
+	else
+	{
+		std::cerr << "\n" << __FILE__ << ":[]:Index out of range.\n"
+			<< "Recieved " << index << ", allowable range is 0 to "
+			<< arena->genes - 1 << "."
+			<< std::endl;
+		throw index_error();
+	};
+};
+
+template <class G> void gene_arena<G>::view::copy(view source)
+{
+	std::copy(source.genes, source.genes + arena->genes, genes);
+	fitness() = source.fitness();
+	arena->changes[row] = source.arena->changes[source.row];
+};
+
+template <class G> void gene_arena<G>::view::load(const G * values)
+{
+	std::copy(values, values + arena->genes, genes);
+	arena->changes[row] = 1;
+};
+
+template <class G> void gene_arena<G>::view::reload()
+{
+	reload(thread_engine());
+};
+
+template <class G> template <class R> if_engine<R,void> 
+	gene_arena<G>::view::reload(R & rng)
+{
+	for (unsigned int i=0; i < arena->genes; i++)
+	{
+		genes[i] = (G) (rng() >> 32);
+	};
+	arena->changes[row] = 1;
+};
+
+template <class G> void gene_arena<G>::view::recombine(view a, view b, 
+	unsigned int crossover)
+{
+	unsigned int n = arena->genes;
+	if ((crossover >= n) || (a.length() != n) || (b.length() != n))
+	{
+		std::cerr << "\n" << __FILE__ << ":" << __FUNCTION__ 
+			<< ": Errored\n\t(a.length=" << a.length() 
+			<< ", b.length=" << b.length()
+			<< ", crossover=" << crossover 
+			<< ")" << std::endl; 
+		throw recombine_error();
+	};
+	// either part is already in place if its parent is this row.
+	std::copy(a.genes, a.genes + crossover, genes);
+	std::copy(b.genes + crossover, b.genes + n, genes + crossover);
+	arena->changes[row] = 1;
+};
+
+template <class G> void gene_arena<G>::view::splice(view a, view b, 
+	unsigned int start, unsigned int end)
+{
+	unsigned int n = arena->genes;
+	if ((start >= n) || (end >= n) || (a.length() != n) 
+		|| (b.length() != n))
+	{
+		// start or end was out of bounds.
+		std::cerr << "\n" << __FILE__ << ":" << __FUNCTION__ 
+			<< ": Bounds Error\n\t(a.length=" << a.length() 
+			<< ", b.length=" << b.length()
+			<< ", start=" << start
+			<< ", end=" << end 
+			<< ")" << std::endl; 
+		throw splice_error();
+	};
+	bool reverse = start > end;
+	unsigned int astart = std::min(start,end);
+	unsigned int aend = std::max(start,end);
+	// the first and last parts, then the section between.
+	std::copy(a.genes, a.genes + astart, genes);
+	std::copy(a.genes + aend + 1, a.genes + n, genes + aend + 1);
+	if (b.genes == genes)
+	{
+		// b's section is in place already.
+		if (reverse) std::reverse(genes + astart, genes + aend + 1);
+	}
+	else if (reverse)
+	{
+		std::reverse_copy(b.genes + astart, b.genes + aend + 1, 
+			genes + astart);
+	}
+	else
+	{
+		std::copy(b.genes + astart, b.genes + aend + 1, genes + astart);
+	};
+	arena->changes[row] = 1;
+};
+
+template <class G> void gene_arena<G>::view::masked_crossover(view a, 
+	view b, const uint64_t * mask)
+{
+	unsigned int n = arena->genes;
+	if ((a.length() != n) || (b.length() != n))
+	{
+		std::cerr << "\n" << __FILE__ << ":" << __FUNCTION__ 
+			<< ": Errored\n\t(a.length=" << a.length() 
+			<< ", b.length=" << b.length()
+			<< ")" << std::endl; 
+		throw recombine_error();
+	};
+	blend_genes(a.genes, b.genes, mask, genes, n);
+	arena->changes[row] = 1;
+};
+
+template <class G> template <class R> if_engine<R,void> 
+	gene_arena<G>::view::uniform_crossover(view a, view b, R & rng)
+{
+	unsigned int n = arena->genes;
+	if ((a.length() != n) || (b.length() != n))
+	{
+		std::cerr << "\n" << __FILE__ << ":" << __FUNCTION__ 
+			<< ": Errored\n\t(a.length=" << a.length() 
+			<< ", b.length=" << b.length()
+			<< ")" << std::endl; 
+		throw recombine_error();
+	};
+	uniform_genes(a.genes, b.genes, genes, n, rng);
+	arena->changes[row] = 1;
+};
+
+template <class G> void gene_arena<G>::view::multipoint_crossover(view a, 
+	view b, const unsigned int * points, unsigned int count)
+{
+	unsigned int n = arena->genes;
+	bool ordered = true;
+	for (unsigned int i=0; i < count; i++)
+	{
+		if ((points[i] > n) || (i && (points[i] < points[i-1]))) 
+		{
+			ordered = false;
+		};
+	};
+	if (!ordered || (a.length() != n) || (b.length() != n))
+	{
+		std::cerr << "\n" << __FILE__ << ":" << __FUNCTION__ 
+			<< ": Errored\n\t(a.length=" << a.length() 
+			<< ", b.length=" << b.length()
+			<< ", points=";
+		for (unsigned int i=0; i < count; i++)
+		{
+			std::cerr << (i ? "," : "") << points[i];
+		};
+		std::cerr << ")" << std::endl; 
+		throw recombine_error();
+	};
+	multipoint_genes(a.genes, b.genes, points, count, genes, n);
+	arena->changes[row] = 1;
+};
+
+template <class G> template <class R> if_engine<R,void> 
+	gene_arena<G>::view::multipoint_crossover(view a, view b, 
+	unsigned int count, R & rng)
+{
+	unsigned int points[max_crossover_points];
+	if (count > max_crossover_points)
+	{
+		std::cerr << "\n" << __FILE__ << ":" << __FUNCTION__ 
+			<< ": Errored\n\t(count=" << count 
+			<< ", max_points=" << max_crossover_points
+			<< ")" << std::endl; 
+		throw recombine_error();
+	};
+	draw_points(rng, arena->genes, points, count);
+	multipoint_crossover(a, b, points, count);
+};
+
+template <class G> int gene_arena<G>::view::mutate(unsigned int which, 
+	G value)
+{
+	if (which >= arena->genes)
+	{
+		std::cerr << "\n" << __FILE__ << ":" << __FUNCTION__
+			<< ":which out of range.\n\tRecieved " 
+			<< which << ", allowable range is 0 to " << arena->genes - 1 
+			<< "." << std::endl;
+		throw mutate_error();
+	};
+	genes[which] = value;
+	arena->changes[row] = 1;
+	return which;
+};
+
+template <class G> void gene_arena<G>::view::rotate(G amount)
+{
+	for (unsigned int i=0; i < arena->genes; i++)
+	{
+		genes[i] = (G) (genes[i] - amount);
+	};
+	arena->changes[row] = 1;
+};
+
+template <class G> std::string gene_arena<G>::view::enstream()
+{
+	std::string returnme;
+	char workingstring[100];
+	for (unsigned int i=0; i < arena->genes; i++)
+	{
+		snprintf(workingstring,100,"0x%x",genes[i]);
+		returnme += workingstring;
+	};
+	return returnme;
+};
+
+template <class G> gene_arena<G>::gene_arena()
+{
+	block = 0;
+	fitnesses = 0;
+	changes = 0;
+	rows = 0;
+	used = 0;
+	genes = 0;
+	stride = 0;
+};
+
+template <class G> gene_arena<G>::gene_arena(unsigned int rows, 
+	unsigned int length)
+{
+	block = 0;
+	fitnesses = 0;
+	changes = 0;
+	reserve(rows, length);
+};
+
+template <class G> gene_arena<G>::~gene_arena()
+{
+	free(block);
+	delete [] fitnesses;
+	delete [] changes;
+};
+
+template <class G> void gene_arena<G>::reserve(unsigned int _rows, 
+	unsigned int length)
+{
+	free(block);
+	delete [] fitnesses;
+	delete [] changes;
+	block = 0;
+	fitnesses = 0;
+	changes = 0;
+	rows = _rows;
+	used = 0;
+	genes = length;
+	unsigned int per_line = 64 / sizeof(G);
+	stride = (length + per_line - 1) / per_line * per_line;
+	void * memory = 0;
+	if (posix_memalign(&memory, 64, 
+		std::max((size_t) 1, (size_t) rows * stride * sizeof(G))) != 0)
+	{
+		std::cerr << "\n" << __FILE__ << ":" << __FUNCTION__
+			<< ": Unable to allocate " << rows << " rows of " << length 
+			<< " genes." << std::endl;
+		throw allocation_error();
+	};
+	block = (G *) memory;
+	fitnesses = new float[rows];
+	changes = new unsigned char[rows];
+};
+
+template <class G> typename gene_arena<G>::view gene_arena<G>::add()
+{
+	if (used == rows)
+	{
+		std::cerr << "\n" << __FILE__ << ":" << __FUNCTION__
+			<< ": All " << rows << " rows are in use." << std::endl;
+		throw capacity_error();
+	};
+	changes[used] = 1;
+	fitnesses[used] = 0;
+	return view(*this, used++);
+};
+
+template <class G> 
+typename gene_arena<G>::view gene_arena<G>::operator [](unsigned int index)
+{
+	if (index >= used)
+	{
+		std::cerr << "\n" << __FILE__ << ":[]:Index out of range.\n"
+			<< "Recieved " << index << ", " << used << " rows in use."
+			<< std::endl;
+		throw index_error();
+	};
+	return view(*this, index);
+};
+
+template <class G> void gene_arena<G>::swap(gene_arena<G> & other)
+{
+	std::swap(block, other.block);
+	std::swap(fitnesses, other.fitnesses);
+	std::swap(changes, other.changes);
+	std::swap(rows, other.rows);
+	std::swap(used, other.used);
+	std::swap(genes, other.genes);
+	std::swap(stride, other.stride);
+};
+
+} // namespace ricks_ga
+
+#endif // gene_arena_h
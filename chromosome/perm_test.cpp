@@ -0,0 +1,86 @@
+/***********************************************
+This file is part of the Rick's Generic GA Solver project (https://launchpad.net/ricks-ga).
+
+    Rick's Generic GA Solver is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Rick's Generic GA Solver is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Rick's Generic GA Solver.  If not, see <http://www.gnu.org/licenses/>.
+
+***********************************************/
+
+// permutation chromosome test program
+
+#include <stdlib.h>
+#include <iostream>
+#include "permutation_chromosome.h"
+
+using namespace std;
+
+typedef ricks_ga::permutation_chromosome<unsigned int> chromosome;
+
+// true if c holds each of 0..n-1 once, with 0 first.
+bool valid(chromosome & c, unsigned int n)
+{
+	if ((c.length() != n) || (c[0] != 0)) return false;
+	vector<bool> seen(n,false);
+	for (unsigned int i=0; i < n; i++)
+	{
+		if ((c[i] >= n) || seen[c[i]]) return false;
+		seen[c[i]] = true;
+	};
+	return true;
+};
+
+int main()
+{
+	srand48(1);
+	int failures = 0;
+	chromosome::workspace w;
+	unsigned int sizes[] = {2, 3, 10, 101};
+	for (int s=0; s < 4; s++)
+	{
+		unsigned int n = sizes[s];
+		for (int trial=0; trial < 1000; trial++)
+		{
+			chromosome a(n), b(n), child;
+			unsigned int begin = lrand48() % n;
+			unsigned int end = lrand48() % n;
+			child.order_crossover(a, b, begin, end, w);
+			if (!valid(child, n)) failures++;
+			// the segment comes from a.
+			for (unsigned int i=max(1u,min(begin,end)); i < max(begin,end); i++)
+			{
+				if (child[i] != a[i]) failures++;
+			};
+			child.partially_mapped_crossover(a, b, begin, end, w);
+			if (!valid(child, n)) failures++;
+			for (unsigned int i=max(1u,min(begin,end)); i < max(begin,end); i++)
+			{
+				if (child[i] != a[i]) failures++;
+			};
+			child.edge_recombination(a, b, w);
+			if (!valid(child, n)) failures++;
+			child.swap(lrand48() % n, lrand48() % n);
+			if (!valid(child, n)) failures++;
+			child.invert(lrand48() % n, lrand48() % n);
+			if (!valid(child, n)) failures++;
+		};
+		// crossing a chromosome with itself gives it back.
+		chromosome a(n), b, child;
+		b.load(a.data(), n);
+		child.edge_recombination(a, b, w);
+		if (child.enstream() != a.enstream()) failures++;
+		child.order_crossover(a, b, 0, n / 2, w);
+		if (child.enstream() != a.enstream()) failures++;
+	};
+	cout << "permutation_chromosome: " << failures << " failures." << endl;
+	return failures ? 1 : 0;
+};
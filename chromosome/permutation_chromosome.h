@@ -0,0 +1,398 @@
+/***********************************************
+This file is part of the Rick's Generic GA Solver project (https://launchpad.net/ricks-ga).
+
+    Rick's Generic GA Solver is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Rick's Generic GA Solver is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Rick's Generic GA Solver.  If not, see <http://www.gnu.org/licenses/>.
+
+***********************************************/
+/* permutation_chromosome.h - presents the permutation chromosome template.
+*/
+
+#ifndef permutation_chromosome_h
+#define permutation_chromosome_h
+
+#include <stdlib.h>
+#include <vector>
+#include <string>
+#include <sstream>
+#include <algorithm>
+#include <iostream>
+#include "random_engine.h"
+
+namespace ricks_ga
+{
+
+/** Chromosome holding an ordering of 0..length()-1 directly.
+ ** 
+ ** Where basic_chromosome holds keys which have to be sorted to give an
+ ** order, this holds the order itself, so a tour needs no decoding and 
+ ** every chromosome is a valid one. It provides the usual order 
+ ** preserving crossovers (order, partially mapped and edge 
+ ** recombination) and swap and inversion mutations.
+ ** 
+ ** Position 0 is never moved by any of them: a new chromosome starts 
+ ** with 0 there and children take it from their parents, so in a 
+ ** population that keeps its first element every tour starts at the 
+ ** same place. Crossover and mutation positions of 0 are treated as 1.
+ ** 
+ ** The crossovers take their working storage from a caller supplied 
+ ** workspace and reuse the child's own storage, so once both have grown
+ ** to the chromosome length no memory is allocated. A child must not 
+ ** be one of its own parents.
+ ** 
+ ** I is the integer type of the elements.
+ **/
+template <class I>
+class permutation_chromosome
+{
+	private:
+		std::vector<I> order;
+	public:
+		/// Parent for all permutation_chromosome exceptions.
+		class general_exception: public std::exception {};
+		/// Thrown if parents of different lengths are crossed.
+		class length_error: public general_exception {};
+		/// Thrown if a mutation position is out of range.
+		class index_error: public general_exception {};
+		/** Working storage for the crossovers.
+		 ** 
+		 ** Each breeder should own one; it grows to the chromosome 
+		 ** length on first use.
+		 **/
+		struct workspace
+		{
+			/// where each element is in a parent.
+			std::vector<I> position;
+			/// elements already placed in the child.
+			std::vector<unsigned char> taken;
+			/// each element's neighbors in either parent, 4 per element.
+			std::vector<I> edges;
+			/// number of entries used in edges per element.
+			std::vector<unsigned char> degree;
+		};
+		/// Creates an empty chromosome.
+		permutation_chromosome();
+		/// Creates a chromosome of length elements in random order.
+		permutation_chromosome(unsigned int length);
+		/** Reloads the chromosome with 0 followed by 1..length-1 in 
+		 ** random order, drawn from the calling thread's thread_engine().
+		 **/
+		void reload(unsigned int length);
+		/// reload(length) with the order drawn from rng.
+		template <class R> if_engine<R,void> reload(unsigned int length,
+			R & rng);
+		/// Replaces the order with the length elements starting at values.
+		void load(const I * values, unsigned int length);
+		/// Returns the number of elements.
+		unsigned int length();
+		/// Read only access to the element at index.
+		const I & operator [](unsigned int index);
+		/// The elements, in order, for readers that want them all.
+		const I * data();
+		/** Order crossover (OX).
+		 ** 
+		 ** The child gets a's elements in positions begin to end-1, and 
+		 ** the remaining positions, from end onwards and round to begin,
+		 ** get the elements not yet used in the order they appear in b 
+		 ** from position end onwards. begin and end may be given either 
+		 ** way round.
+		 **/
+		void order_crossover(permutation_chromosome<I> & a, 
+			permutation_chromosome<I> & b, unsigned int begin, 
+			unsigned int end, workspace & w);
+		/** Partially mapped crossover (PMX).
+		 ** 
+		 ** The child gets a's elements in positions begin to end-1 and 
+		 ** b's everywhere else, except that each of b's elements pushed
+		 ** out of the segment goes to the position of the element that
+		 ** displaced it (following the mapping until it leaves the 
+		 ** segment), so no element appears twice.
+		 **/
+		void partially_mapped_crossover(permutation_chromosome<I> & a, 
+			permutation_chromosome<I> & b, unsigned int begin, 
+			unsigned int end, workspace & w);
+		/** Edge recombination crossover (ERX).
+		 ** 
+		 ** Builds the child from the neighbor relationships (edges) of 
+		 ** both parents: starting from a's first element, it steps each 
+		 ** time to the unused neighbor that itself has the fewest unused
+		 ** neighbors left (ties going to a's successor, a's predecessor,
+		 ** b's successor and b's predecessor, in that order), and to the
+		 ** next unused element of a when none is left. Most of the 
+		 ** child's edges come from one parent or the other.
+		 **/
+		void edge_recombination(permutation_chromosome<I> & a, 
+			permutation_chromosome<I> & b, workspace & w);
+		/// Swaps the elements at positions i and j.
+		void swap(unsigned int i, unsigned int j);
+		/** Reverses the order of the elements in positions begin to end,
+		 ** inclusive; they may be given either way round. In a tour this
+		 ** is a 2-opt move, replacing just two edges.
+		 **/
+		void invert(unsigned int begin, unsigned int end);
+		/** Encodes the chromosome as its elements in decimal separated by
+		 ** commas, e.g. "0,3,1,2".
+		 **/
+		std::string enstream();
+};
+
+// definition starts below
+
+template <class I> permutation_chromosome<I>::permutation_chromosome()
+{
+	order.clear();
+};
+
+template <class I> 
+permutation_chromosome<I>::permutation_chromosome(unsigned int length)
+{
+	reload(length);
+};
+
+template <class I> void permutation_chromosome<I>::reload(unsigned int length)
+{
+	reload(length, thread_engine());
+};
+
+template <class I> template <class R> if_engine<R,void> 
+	permutation_chromosome<I>::reload(unsigned int length, R & rng)
+{
+	order.resize(length);
+	for (unsigned int i=0; i < length; i++)
+	{
+		order[i] = i;
+	};
+	// Fisher-Yates over all but position 0.
+	for (unsigned int i=length; i > 2; i--)
+	{
+		unsigned int j = 1 + below(rng, i - 1);
+		std::swap(order[i-1], order[j]);
+	};
+};
+
+template <class I> void permutation_chromosome<I>::load(const I * values, 
+	unsigned int length)
+{
+	order.assign(values, values + length);
+};
+
+template <class I> unsigned int permutation_chromosome<I>::length()
+{
+	return order.size();
+};
+
+template <class I> 
+const I & permutation_chromosome<I>::operator [](unsigned int index)
+{
+	return order[index];
+};
+
+template <class I> const I * permutation_chromosome<I>::data()
+{
+	return order.data();
+};
+
+template <class I> void permutation_chromosome<I>::order_crossover(
+	permutation_chromosome<I> & a, permutation_chromosome<I> & b, 
+	unsigned int begin, unsigned int end, workspace & w)
+{
+	unsigned int n = a.length();
+	if ((b.length() != n) || (n < 2))
+	{
+		std::cerr << "\n" << __FILE__ << ":" << __FUNCTION__
+			<< ": parents are " << n << " and " << b.length() 
+			<< " long." << std::endl;
+		throw length_error();
+	};
+	if (begin > end) std::swap(begin, end);
+	begin = std::max(1u, std::min(begin, n));
+	end = std::max(1u, std::min(end, n));
+	order.resize(n);
+	w.taken.assign(n, 0);
+	order[0] = a.order[0];
+	w.taken[order[0]] = 1;
+	for (unsigned int i=begin; i < end; i++)
+	{
+		order[i] = a.order[i];
+		w.taken[order[i]] = 1;
+	};
+	// the rest, in b's order from end, go in from end round to begin.
+	unsigned int m = n - 1;
+	unsigned int fill = end;
+	for (unsigned int k=0; k < m; k++)
+	{
+		I value = b.order[1 + (end - 1 + k) % m];
+		if (w.taken[value]) continue;
+		if (fill == n) fill = 1;
+		order[fill++] = value;
+	};
+};
+
+template <class I> void permutation_chromosome<I>::partially_mapped_crossover(
+	permutation_chromosome<I> & a, permutation_chromosome<I> & b, 
+	unsigned int begin, unsigned int end, workspace & w)
+{
+	unsigned int n = a.length();
+	if ((b.length() != n) || (n < 2))
+	{
+		std::cerr << "\n" << __FILE__ << ":" << __FUNCTION__
+			<< ": parents are " << n << " and " << b.length() 
+			<< " long." << std::endl;
+		throw length_error();
+	};
+	if (begin > end) std::swap(begin, end);
+	begin = std::max(1u, std::min(begin, n));
+	end = std::max(1u, std::min(end, n));
+	order.assign(b.order.begin(), b.order.end());
+	w.position.resize(n);
+	w.taken.assign(n, 0);
+	for (unsigned int i=0; i < n; i++)
+	{
+		w.position[b.order[i]] = i;
+	};
+	for (unsigned int i=begin; i < end; i++)
+	{
+		order[i] = a.order[i];
+		w.taken[order[i]] = 1;
+	};
+	// b's elements pushed out of the segment.
+	for (unsigned int i=begin; i < end; i++)
+	{
+		I value = b.order[i];
+		if (w.taken[value]) continue;
+		unsigned int j = i;
+		while ((j >= begin) && (j < end))
+		{
+			j = w.position[a.order[j]];
+		};
+		order[j] = value;
+	};
+};
+
+template <class I> void permutation_chromosome<I>::edge_recombination(
+	permutation_chromosome<I> & a, permutation_chromosome<I> & b, 
+	workspace & w)
+{
+	unsigned int n = a.length();
+	if ((b.length() != n) || (n < 2))
+	{
+		std::cerr << "\n" << __FILE__ << ":" << __FUNCTION__
+			<< ": parents are " << n << " and " << b.length() 
+			<< " long." << std::endl;
+		throw length_error();
+	};
+	w.edges.resize(4 * (size_t) n);
+	w.degree.assign(n, 0);
+	w.taken.assign(n, 0);
+	// the edge table, without duplicates.
+	permutation_chromosome<I> * parents[2] = {&a, &b};
+	for (int p=0; p < 2; p++)
+	{
+		const std::vector<I> & o = parents[p]->order;
+		for (unsigned int i=0; i < n; i++)
+		{
+			I at = o[i];
+			I near[2] = {o[(i + 1) % n], o[(i + n - 1) % n]};
+			for (int k=0; k < 2; k++)
+			{
+				I * list = &w.edges[4 * (size_t) at];
+				if (std::find(list, list + w.degree[at], near[k]) 
+					== list + w.degree[at])
+				{
+					list[w.degree[at]++] = near[k];
+				};
+			};
+		};
+	};
+	order.resize(n);
+	I current = a.order[0];
+	order[0] = current;
+	w.taken[current] = 1;
+	unsigned int scan = 0;
+	for (unsigned int i=1; i < n; i++)
+	{
+		// the unused neighbor with the fewest unused neighbors.
+		const I * list = &w.edges[4 * (size_t) current];
+		unsigned int best = n;
+		unsigned int fewest = 5;
+		for (unsigned int k=0; k < w.degree[current]; k++)
+		{
+			I candidate = list[k];
+			if (w.taken[candidate]) continue;
+			const I * next = &w.edges[4 * (size_t) candidate];
+			unsigned int left = 0;
+			for (unsigned int e=0; e < w.degree[candidate]; e++)
+			{
+				left += !w.taken[next[e]];
+			};
+			if (left < fewest)
+			{
+				fewest = left;
+				best = candidate;
+			};
+		};
+		if (best == n)
+		{
+			while (w.taken[a.order[scan]]) scan++;
+			best = a.order[scan];
+		};
+		current = best;
+		order[i] = current;
+		w.taken[current] = 1;
+	};
+};
+
+template <class I> void permutation_chromosome<I>::swap(unsigned int i, 
+	unsigned int j)
+{
+	if ((i >= order.size()) || (j >= order.size()))
+	{
+		std::cerr << "\n" << __FILE__ << ":" << __FUNCTION__
+			<< ": position out of range.\n\tRecieved " << i << " and " << j
+			<< ", allowable range is 0 to " << order.size()-1 << "."
+			<< std::endl;
+		throw index_error();
+	};
+	std::swap(order[std::max(1u, i)], order[std::max(1u, j)]);
+};
+
+template <class I> void permutation_chromosome<I>::invert(unsigned int begin,
+	unsigned int end)
+{
+	if ((begin >= order.size()) || (end >= order.size()))
+	{
+		std::cerr << "\n" << __FILE__ << ":" << __FUNCTION__
+			<< ": position out of range.\n\tRecieved " << begin << " and " 
+			<< end << ", allowable range is 0 to " << order.size()-1 << "."
+			<< std::endl;
+		throw index_error();
+	};
+	if (begin > end) std::swap(begin, end);
+	begin = std::max(1u, begin);
+	std::reverse(order.begin() + begin, order.begin() + std::max(begin, end) + 1);
+};
+
+template <class I> std::string permutation_chromosome<I>::enstream()
+{
+	std::stringstream returnme;
+	for (unsigned int i=0; i < order.size(); i++)
+	{
+		if (i) returnme << ",";
+		returnme << (unsigned long int) order[i];
+	};
+	return returnme.str();
+};
+
+} // namespace ricks_ga
+
+#endif // permutation_chromosome_h
@@ -0,0 +1,346 @@
+/***********************************************
+This file is part of the Rick's Generic GA Solver project (https://launchpad.net/ricks-ga).
+
+    Rick's Generic GA Solver is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Rick's Generic GA Solver is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Rick's Generic GA Solver.  If not, see <http://www.gnu.org/licenses/>.
+
+***********************************************/
+/* random_engine.h - random number engines for the chromosome templates.
+*/
+
+#ifndef random_engine_h
+#define random_engine_h
+
+#include <stdint.h>
+#include <atomic>
+#include <type_traits>
+#include <algorithm>
+#include <math.h>
+
+namespace ricks_ga
+{
+
+class random_buffer;
+
+/** xoshiro256** (Blackman and Vigna), a UniformRandomBitGenerator with
+ ** 256 bits of state. Not thread safe; give each thread its own.
+ **/
+class xoshiro256ss
+{
+	private:
+		uint64_t s[4];
+		static inline uint64_t rotl(uint64_t x, int k)
+		{
+			return (x << k) | (x >> (64 - k));
+		};
+		// splitmix64, used to spread a seed over the state.
+		static inline uint64_t splitmix(uint64_t & x)
+		{
+			uint64_t z = (x += 0x9e3779b97f4a7c15ULL);
+			z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+			z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+			return z ^ (z >> 31);
+		};
+	public:
+		friend class random_buffer;
+		typedef uint64_t result_type;
+		static const uint64_t default_seed = 0x2545f4914f6cdd1dULL;
+		/// An engine for stream of seed.
+		explicit xoshiro256ss(uint64_t seed = default_seed, 
+			uint64_t stream = 0) 
+		{ 
+			this->seed(seed, stream); 
+		};
+		/// Restarts the engine on stream of seed.
+		void seed(uint64_t seed, uint64_t stream = 0)
+		{
+			uint64_t x = seed ^ splitmix(stream);
+			for (int i=0; i < 4; i++)
+			{
+				s[i] = splitmix(x);
+			};
+		};
+		/// The next 64 random bits.
+		inline result_type operator ()()
+		{
+			const uint64_t returnme = rotl(s[1] * 5, 7) * 9;
+			const uint64_t t = s[1] << 17;
+			s[2] ^= s[0];
+			s[3] ^= s[1];
+			s[1] ^= s[2];
+			s[0] ^= s[3];
+			s[2] ^= t;
+			s[3] = rotl(s[3], 45);
+			return returnme;
+		};
+		/** Advances the engine 2^128 steps, for up to 2^128 streams that 
+		 ** are certain not to overlap.
+		 **/
+		void jump()
+		{
+			static const uint64_t steps[] = { 0x180ec6d33cfd0abaULL, 
+				0xd5a61266f0c9392cULL, 0xa9582618e03fc9aaULL, 
+				0x39abdc4529b1661cULL };
+			uint64_t t[4] = {0, 0, 0, 0};
+			for (int i=0; i < 4; i++)
+			{
+				for (int b=0; b < 64; b++)
+				{
+					if (steps[i] & (1ULL << b))
+					{
+						for (int k=0; k < 4; k++) t[k] ^= s[k];
+					};
+					(*this)();
+				};
+			};
+			for (int k=0; k < 4; k++) s[k] = t[k];
+		};
+		static constexpr result_type min() { return 0; };
+		static constexpr result_type max() { return ~(result_type) 0; };
+};
+
+/// The engine the chromosome templates use when none is supplied.
+typedef xoshiro256ss default_engine;
+
+/** The calling thread's own engine, used by the chromosome methods that
+ ** are not given one. Only repeatable on a single thread.
+ **/
+inline default_engine & thread_engine()
+{
+	static std::atomic<uint64_t> streams(0);
+	thread_local default_engine returnme(default_engine::default_seed, 
+		streams++);
+	return returnme;
+};
+
+/** Return type T for members that take an engine R, so they do not 
+ ** compete with the overloads taking gene indexes and values.
+ **/
+template <class R, class T> using if_engine = 
+	typename std::enable_if<std::is_class<R>::value, T>::type;
+
+/// A float in [0,1) from the top 24 bits of one 64 bit draw of rng.
+template <class R> inline float unit_float(R & rng)
+{
+	return (rng() >> 40) * (1.0f / 16777216.0f);
+};
+
+/** A UniformRandomBitGenerator that fills a block of numbers at a time
+ ** from lanes xoshiro256** engines stepped side by side. Not thread 
+ ** safe; give each thread its own.
+ **/
+class random_buffer
+{
+	private:
+		static const unsigned int lanes = 32;
+		static const unsigned int block = 2048;
+		typedef uint64_t lane_state[4][lanes];
+		lane_state s;
+		uint32_t words[block];
+		unsigned int next;
+		void (*fill)(lane_state & s, uint32_t * words);
+		// steps the lanes to fill a block; compiled below for each CPU.
+		static inline __attribute__((always_inline)) void fill_block(
+			lane_state & s, uint32_t * words)
+		{
+			uint64_t s0[lanes], s1[lanes], s2[lanes], s3[lanes];
+			for (unsigned int l=0; l < lanes; l++)
+			{
+				s0[l] = s[0][l];
+				s1[l] = s[1][l];
+				s2[l] = s[2][l];
+				s3[l] = s[3][l];
+			};
+			for (unsigned int w=0; w < block; w += 2 * lanes)
+			{
+				uint64_t out[lanes];
+				for (unsigned int l=0; l < lanes; l++)
+				{
+					uint64_t x = s1[l] + (s1[l] << 2);
+					x = (x << 7) | (x >> 57);
+					out[l] = x + (x << 3);
+					const uint64_t t = s1[l] << 17;
+					s2[l] ^= s0[l];
+					s3[l] ^= s1[l];
+					s1[l] ^= s2[l];
+					s0[l] ^= s3[l];
+					s2[l] ^= t;
+					s3[l] = (s3[l] << 45) | (s3[l] >> 19);
+				};
+				for (unsigned int l=0; l < lanes; l++)
+				{
+					words[w + 2 * l] = (uint32_t) out[l];
+					words[w + 2 * l + 1] = (uint32_t) (out[l] >> 32);
+				};
+			};
+			for (unsigned int l=0; l < lanes; l++)
+			{
+				s[0][l] = s0[l];
+				s[1][l] = s1[l];
+				s[2][l] = s2[l];
+				s[3][l] = s3[l];
+			};
+		};
+		static void fill_scalar(lane_state & s, uint32_t * words)
+		{
+			fill_block(s, words);
+		};
+		__attribute__((target("avx2")))
+		static void fill_avx2(lane_state & s, uint32_t * words)
+		{
+			fill_block(s, words);
+		};
+		__attribute__((target("avx512f")))
+		static void fill_avx512(lane_state & s, uint32_t * words)
+		{
+			fill_block(s, words);
+		};
+		void refill()
+		{
+			fill(s, words);
+			next = 0;
+		};
+	public:
+		typedef uint64_t result_type;
+		/// A buffer for stream of seed.
+		explicit random_buffer(uint64_t seed = xoshiro256ss::default_seed,
+			uint64_t stream = 0)
+		{
+			this->seed(seed, stream);
+		};
+		/// Restarts the buffer on stream of seed.
+		void seed(uint64_t seed, uint64_t stream = 0)
+		{
+			xoshiro256ss e(seed, stream);
+			for (unsigned int l=0; l < lanes; l++)
+			{
+				for (int k=0; k < 4; k++) s[k][l] = e.s[k];
+				e.jump();
+			};
+			next = block;
+			// every version gives the same numbers, only faster.
+			__builtin_cpu_init();
+			fill = fill_scalar;
+			if (__builtin_cpu_supports("avx2")) fill = fill_avx2;
+			if (__builtin_cpu_supports("avx512f")) fill = fill_avx512;
+		};
+		/// The next 32 random bits.
+		inline uint32_t bits()
+		{
+			if (next == block) refill();
+			return words[next++];
+		};
+		/// The next 64 random bits.
+		inline result_type operator ()()
+		{
+			uint64_t high = bits();
+			return (high << 32) | bits();
+		};
+		/// A number from 0 to n-1, every one equally likely; 0 if n is 0.
+		inline uint32_t below(uint32_t n)
+		{
+			uint64_t m = (uint64_t) bits() * n;
+			uint32_t low = (uint32_t) m;
+			if (low < n)
+			{
+				const uint32_t floor = -n % n;
+				while (low < floor)
+				{
+					m = (uint64_t) bits() * n;
+					low = (uint32_t) m;
+				};
+			};
+			return m >> 32;
+		};
+		/// A float in [0,1), from 24 random bits.
+		inline float unit()
+		{
+			return (bits() >> 8) * (1.0f / 16777216.0f);
+		};
+		/// Fills out with count unit() values.
+		void units(float * out, unsigned int count)
+		{
+			while (count)
+			{
+				if (next == block) refill();
+				unsigned int take = std::min(count, block - next);
+				const uint32_t * from = &words[next];
+				for (unsigned int i=0; i < take; i++)
+				{
+					out[i] = (from[i] >> 8) * (1.0f / 16777216.0f);
+				};
+				next += take;
+				out += take;
+				count -= take;
+			};
+		};
+		static constexpr result_type min() { return 0; };
+		static constexpr result_type max() { return ~(result_type) 0; };
+};
+
+/** A number from 0 to n-1 drawn from rng, without bias; see 
+ ** random_buffer::below().
+ **/
+template <class R> inline uint32_t below(R & rng, uint32_t n)
+{
+	uint64_t m = (rng() >> 32) * n;
+	uint32_t low = (uint32_t) m;
+	if (low < n)
+	{
+		const uint32_t floor = -n % n;
+		while (low < floor)
+		{
+			m = (rng() >> 32) * n;
+			low = (uint32_t) m;
+		};
+	};
+	return m >> 32;
+};
+
+inline uint32_t below(random_buffer & rng, uint32_t n)
+{
+	return rng.below(n);
+};
+
+/** The gaps between successes in a run of trials that each succeed 
+ ** with odds p: next() is the number of failures before the next one. 
+ ** p of 0 or less never succeeds; 1 or more always does.
+ **/
+class geometric_skip
+{
+	private:
+		// 1/log(1-p), or 0 if every trial succeeds.
+		double scale;
+		bool never;
+	public:
+		static const unsigned long long int forever = ~0ULL;
+		explicit geometric_skip(double p = 0)
+		{
+			never = !(p > 0);
+			scale = (p < 1) ? 1.0 / log1p(-p) : 0.0;
+		};
+		/// Failures before the next success; forever if there is none.
+		template <class R> unsigned long long int next(R & rng)
+		{
+			if (never) return forever;
+			// u is on (0,1], so log(u) is finite.
+			double u = ((rng() >> 11) + 1) * (1.0 / 9007199254740992.0);
+			double k = floor(log(u) * scale);
+			if (k >= 1.8e19) return forever;
+			return (unsigned long long int) k;
+		};
+};
+
+} // namespace ricks_ga
+
+#endif // random_engine_h
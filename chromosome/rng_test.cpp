@@ -0,0 +1,536 @@
+/***********************************************
+This file is part of the Rick's Generic GA Solver project (https://launchpad.net/ricks-ga).
+
+    Rick's Generic GA Solver is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Rick's Generic GA Solver is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Rick's Generic GA Solver.  If not, see <http://www.gnu.org/licenses/>.
+
+***********************************************/
+// random engine test and timing program
+
+#include "basic_chromosome.h"
+#include "permutation_chromosome.h"
+#include "gene_arena.h"
+#include <stdlib.h>
+#include <sys/time.h>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <thread>
+#include <sstream>
+#include <math.h>
+
+using namespace std;
+using ricks_ga::xoshiro256ss;
+using ricks_ga::random_buffer;
+
+typedef ricks_ga::basic_chromosome<unsigned char> chromosome;
+typedef ricks_ga::permutation_chromosome<unsigned int> permutation;
+typedef ricks_ga::gene_arena<unsigned char> arena;
+
+double now()
+{
+	timeval t;
+	gettimeofday(&t,0);
+	return t.tv_sec + t.tv_usec * 1e-6;
+};
+
+// reference: xoshiro256** as published, seeded as the engine seeds.
+struct reference
+{
+	uint64_t s[4];
+	static uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); };
+	static uint64_t splitmix(uint64_t & x)
+	{
+		uint64_t z = (x += 0x9e3779b97f4a7c15ULL);
+		z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+		z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+		return z ^ (z >> 31);
+	};
+	reference(uint64_t seed, uint64_t stream)
+	{
+		uint64_t x = seed ^ splitmix(stream);
+		for (int i=0; i < 4; i++) s[i] = splitmix(x);
+	};
+	uint64_t next()
+	{
+		const uint64_t result = rotl(s[1] * 5, 7) * 9;
+		const uint64_t t = s[1] << 17;
+		s[2] ^= s[0];
+		s[3] ^= s[1];
+		s[1] ^= s[2];
+		s[0] ^= s[3];
+		s[2] ^= t;
+		s[3] = rotl(s[3], 45);
+		return result;
+	};
+};
+
+int fail(const char * what)
+{
+	cout << "FAILED: " << what << endl;
+	return 1;
+};
+
+int check_engine()
+{
+	int errors = 0;
+	for (uint64_t seed=0; seed < 4; seed++)
+	{
+		for (uint64_t stream=0; stream < 4; stream++)
+		{
+			xoshiro256ss e(seed, stream);
+			reference r(seed, stream);
+			for (int i=0; i < 1000; i++)
+			{
+				if (e() != r.next()) return fail("engine != reference");
+			};
+		};
+	};
+	// streams of a seed, and seeds, give different numbers.
+	xoshiro256ss a(7), b(7,1), c(8), d(7);
+	if ((a() == b()) || (c() == d())) errors += fail("streams repeat");
+	// a jumped engine does not start where it was.
+	xoshiro256ss j(7);
+	j.jump();
+	xoshiro256ss k(7);
+	vector<uint64_t> first(1000);
+	for (unsigned int i=0; i < first.size(); i++) first[i] = k();
+	if (find(first.begin(), first.end(), j()) != first.end())
+	{
+		errors += fail("jump");
+	};
+	// unit_float stays in [0,1) and rand_index covers its range evenly.
+	chromosome genes(10);
+	vector<unsigned int> counts(10,0);
+	for (int i=0; i < 100000; i++)
+	{
+		float f = ricks_ga::unit_float(a);
+		if ((f < 0) || (f >= 1)) return fail("unit_float range");
+		counts[genes.rand_index(a)]++;
+	};
+	for (unsigned int i=0; i < counts.size(); i++)
+	{
+		if ((counts[i] < 9500) || (counts[i] > 10500)) 
+		{
+			errors += fail("rand_index spread");
+		};
+	};
+	return errors;
+};
+
+int check_buffer()
+{
+	int errors = 0;
+	// the words are the lanes' engines, a jump apart, interleaved.
+	random_buffer buffer(5, 2);
+	vector<xoshiro256ss> lanes(32, xoshiro256ss(5, 2));
+	for (unsigned int l=1; l < lanes.size(); l++)
+	{
+		lanes[l] = lanes[l-1];
+		lanes[l].jump();
+	};
+	for (int w=0; w < 5000; w += 64)
+	{
+		for (unsigned int l=0; l < lanes.size(); l++)
+		{
+			uint64_t x = lanes[l]();
+			uint32_t low = buffer.bits();
+			uint32_t high = buffer.bits();
+			if ((low != (uint32_t) x) || (high != (x >> 32))) 
+			{
+				return fail("buffer != lanes");
+			};
+		};
+	};
+	// below() stays in range, evenly, including n that do not divide 2^32.
+	uint32_t sizes[] = {1, 3, 10, 1000, 3000000000U};
+	for (int k=0; k < 5; k++)
+	{
+		uint32_t n = sizes[k];
+		vector<unsigned int> counts(10,0);
+		for (int i=0; i < 100000; i++)
+		{
+			uint32_t x = buffer.below(n);
+			if (x >= n) return fail("below range");
+			counts[(uint64_t) x * 10 / n]++;
+		};
+		for (unsigned int i=0; (n >= 10) && (i < counts.size()); i++)
+		{
+			if ((counts[i] < 9500) || (counts[i] > 10500)) 
+			{
+				errors += fail("below spread");
+			};
+		};
+	};
+	if (buffer.below(0) != 0) errors += fail("below(0)");
+	// units() gives what unit() would have, across refills.
+	random_buffer a(9), b(9);
+	vector<float> batch(3000);
+	a.bits();
+	b.bits();
+	a.units(&batch[0], batch.size());
+	for (unsigned int i=0; i < batch.size(); i++)
+	{
+		float f = b.unit();
+		if ((batch[i] != f) || (f < 0) || (f >= 1)) return fail("units");
+	};
+	if (a.bits() != b.bits()) errors += fail("units position");
+	return errors;
+};
+
+// skips average (1-p)/p, and successes come at the rate p.
+int check_skip()
+{
+	int errors = 0;
+	random_buffer rng(3);
+	double rates[] = {0.5, 0.04, 1e-3, 1e-6};
+	for (int k=0; k < 4; k++)
+	{
+		double p = rates[k];
+		ricks_ga::geometric_skip skips(p);
+		double total = 0;
+		const int n = 200000;
+		for (int i=0; i < n; i++) total += skips.next(rng);
+		double expected = (1 - p) / p;
+		// the standard error of the mean is sqrt(1-p)/p/sqrt(n).
+		if (fabs(total / n - expected) > 5 * sqrt(1 - p) / p / sqrt(n))
+		{
+			errors += fail("skip mean");
+		};
+	};
+	ricks_ga::geometric_skip never(0), always(1), negative(-1);
+	if ((never.next(rng) != ricks_ga::geometric_skip::forever)
+		|| (negative.next(rng) != ricks_ga::geometric_skip::forever)
+		|| (always.next(rng) != 0))
+	{
+		errors += fail("skip limits");
+	};
+	return errors;
+};
+
+// the same seed gives the same chromosomes, whatever the thread.
+int check_repeat()
+{
+	int errors = 0;
+	xoshiro256ss r1(42), r2(42);
+	chromosome a, b, ma, mb, ca, cb;
+	a.reload(500, r1);
+	b.reload(500, r2);
+	if (a.enstream() != b.enstream()) errors += fail("reload repeat");
+	ma.reload(500, r1);
+	mb.reload(500, r2);
+	ma.mutate(r1);
+	mb.mutate(r2);
+	ma.mutate(3, r1);
+	mb.mutate(3, r2);
+	if (ma.enstream() != mb.enstream()) errors += fail("mutate repeat");
+	ca.splice(a, ma, r1);
+	cb.splice(b, mb, r2);
+	ca.recombine(ca, a, r1);
+	cb.recombine(cb, b, r2);
+	if (ca.enstream() != cb.enstream()) errors += fail("breed repeat");
+	permutation pa, pb;
+	pa.reload(500, r1);
+	pb.reload(500, r2);
+	if (pa.enstream() != pb.enstream()) errors += fail("permutation repeat");
+	arena aa, ab;
+	aa.reserve(1, 500);
+	ab.reserve(1, 500);
+	aa.add().reload(r1);
+	ab.add().reload(r2);
+	if (aa[0].enstream() != ab[0].enstream()) errors += fail("arena repeat");
+	// engines seeded alike on other threads agree too.
+	string other;
+	thread t([&other]()
+	{
+		xoshiro256ss r(42);
+		chromosome c;
+		c.reload(500, r);
+		other = c.enstream();
+	});
+	t.join();
+	if (other != a.enstream()) errors += fail("thread repeat");
+	return errors;
+};
+
+// each thread's default engine is its own stream.
+int check_threads()
+{
+	uint64_t here = ricks_ga::thread_engine()();
+	uint64_t there = 0;
+	thread t([&there]() { there = ricks_ga::thread_engine()(); });
+	t.join();
+	return (here == there) ? fail("thread engines repeat") : 0;
+};
+
+// ns per gene to reload n genes from lrand48() and from the engine.
+void timing()
+{
+	unsigned int n = 1000;
+	unsigned int reps = 100000;
+	xoshiro256ss rng(1);
+	vector<unsigned char> old_genes;
+	chromosome c;
+	unsigned long long int sink = 0;
+	double ns[3];
+	for (int k=0; k < 3; k++)
+	{
+		double start = now();
+		for (unsigned int r=0; r < reps; r++)
+		{
+			switch (k)
+			{
+				case 0:
+					// as reload() used to fill genes.
+					old_genes.clear();
+					for (unsigned int i=0; i < n; i++)
+					{
+						old_genes.push_back(lrand48());
+					};
+					sink += old_genes[0];
+					break;
+				case 1: 
+					c = chromosome(); 
+					c.reload(n, rng); 
+					sink += c[0];
+					break;
+				default: 
+					c = chromosome(); 
+					c.reload(n); 
+					sink += c[0];
+					break;
+			};
+		};
+		ns[k] = (now() - start) * 1e9 / ((double) reps * n);
+	};
+	const char * names[] = {"lrand48", "engine", "thread_engine"};
+	for (int k=0; k < 3; k++)
+	{
+		cout << setw(14) << names[k] 
+			<< setw(14) << fixed << setprecision(2) << ns[k]
+			<< setw(10) << ns[0] / ns[k] << "x"
+			<< (sink == 1 ? " " : "") << endl;
+	};
+};
+
+// what a source costs for each kind of draw, and for a generation.
+struct draw_costs
+{
+	double index;
+	double bounded;
+	double unit;
+	double units;
+	double generation;
+};
+
+/* a generation's draws as bc_bench makes them, for 2000 chromosomes of 
+ * 1000 genes: tournaments for a 15% breeding list, two splice points a 
+ * child and 4% mutations, decided chromosome by chromosome (the engine, 
+ * as it was drawn) or in one batch (the buffer).
+ */
+unsigned long long int generation(xoshiro256ss & rng, vector<float> & draws)
+{
+	unsigned long long int sink = 0;
+	for (int i=0; i < 600; i++) sink += rng() % 2000;
+	for (int i=0; i < 4000; i++) sink += rng() % 1000;
+	for (int i=0; i < 2000; i++)
+	{
+		if (ricks_ga::unit_float(rng) <= 0.04)
+		{
+			sink += rng() % 1000;
+			sink += rng();
+		};
+	};
+	return sink;
+};
+
+unsigned long long int generation(random_buffer & rng, vector<float> & draws)
+{
+	unsigned long long int sink = 0;
+	for (int i=0; i < 600; i++) sink += rng.below(2000);
+	for (int i=0; i < 4000; i++) sink += rng.below(1000);
+	rng.units(&draws[0], 2000);
+	for (int i=0; i < 2000; i++)
+	{
+		if (draws[i] <= 0.04)
+		{
+			sink += rng.below(1000);
+			sink += rng.bits();
+		};
+	};
+	return sink;
+};
+
+template <class R> draw_costs costs(R & rng)
+{
+	const unsigned int reps = 20000000;
+	draw_costs returnme;
+	unsigned long long int sink = 0;
+	float fsink = 0;
+	vector<float> draws(2000);
+	double start = now();
+	for (unsigned int r=0; r < reps; r++) sink += rng() % 1000;
+	returnme.index = (now() - start) * 1e9 / reps;
+	start = now();
+	for (unsigned int r=0; r < reps; r++) sink += ricks_ga::below(rng, 1000);
+	returnme.bounded = (now() - start) * 1e9 / reps;
+	start = now();
+	for (unsigned int r=0; r < reps; r++) fsink += ricks_ga::unit_float(rng);
+	returnme.unit = (now() - start) * 1e9 / reps;
+	start = now();
+	for (unsigned int r=0; r < reps; r += draws.size())
+	{
+		for (unsigned int i=0; i < draws.size(); i++)
+		{
+			draws[i] = ricks_ga::unit_float(rng);
+		};
+		fsink += draws[0];
+	};
+	returnme.units = (now() - start) * 1e9 / reps;
+	const unsigned int gens = 20000;
+	start = now();
+	for (unsigned int g=0; g < gens; g++) sink += generation(rng, draws);
+	returnme.generation = (now() - start) * 1e6 / gens;
+	if ((sink == 1) || (fsink == 1)) cout << " ";
+	return returnme;
+};
+
+// the buffer's own unit() and units() in place of unit_float().
+template <> draw_costs costs(random_buffer & rng)
+{
+	const unsigned int reps = 20000000;
+	xoshiro256ss unused;
+	draw_costs returnme;
+	unsigned long long int sink = 0;
+	float fsink = 0;
+	vector<float> draws(2000);
+	double start = now();
+	for (unsigned int r=0; r < reps; r++) sink += rng() % 1000;
+	returnme.index = (now() - start) * 1e9 / reps;
+	start = now();
+	for (unsigned int r=0; r < reps; r++) sink += rng.below(1000);
+	returnme.bounded = (now() - start) * 1e9 / reps;
+	start = now();
+	for (unsigned int r=0; r < reps; r++) fsink += rng.unit();
+	returnme.unit = (now() - start) * 1e9 / reps;
+	start = now();
+	for (unsigned int r=0; r < reps; r += draws.size())
+	{
+		rng.units(&draws[0], draws.size());
+		fsink += draws[0];
+	};
+	returnme.units = (now() - start) * 1e9 / reps;
+	const unsigned int gens = 20000;
+	start = now();
+	for (unsigned int g=0; g < gens; g++) sink += generation(rng, draws);
+	returnme.generation = (now() - start) * 1e6 / gens;
+	if ((sink == 1) || (fsink == 1)) cout << " ";
+	return returnme;
+};
+
+void draw_row(const char * label, double engine, double buffer)
+{
+	cout << setw(14) << label 
+		<< setw(14) << fixed << setprecision(2) << engine
+		<< setw(14) << buffer
+		<< setw(10) << engine / buffer << "x" << endl;
+};
+
+/* ns per draw: an index by %, one by below(), a float one at a time and 
+ * in a batch of 2000; then microseconds for a generation's draws.
+ */
+void draw_timing()
+{
+	xoshiro256ss engine(1);
+	random_buffer buffer(1);
+	draw_costs e = costs(engine);
+	draw_costs b = costs(buffer);
+	draw_row("% n", e.index, b.index);
+	draw_row("below(n)", e.bounded, b.bounded);
+	draw_row("float", e.unit, b.unit);
+	draw_row("floats", e.units, b.units);
+	draw_row("generation us", e.generation, b.generation);
+};
+
+/* microseconds to pick the mutated chromosomes of a generation of 2000
+ * (or genes of 2000 x 1000) by testing each one, or by skipping.
+ */
+void skip_timing()
+{
+	random_buffer rng(1);
+	vector<float> draws(2000000);
+	double rates[] = {1e-6, 0.04, 1e-6, 1e-4};
+	unsigned int trials[] = {2000, 2000, 2000000, 2000000};
+	const char * labels[] = {"chromosome", "chromosome", "gene", "gene"};
+	unsigned long long int sink = 0;
+	for (int k=0; k < 4; k++)
+	{
+		unsigned int n = trials[k];
+		unsigned int reps = 20000000 / n;
+		double start = now();
+		for (unsigned int r=0; r < reps; r++)
+		{
+			rng.units(&draws[0], n);
+			for (unsigned int i=0; i < n; i++)
+			{
+				if (draws[i] <= rates[k]) sink += i;
+			};
+		};
+		double tested = (now() - start) * 1e6 / reps;
+		ricks_ga::geometric_skip skips(rates[k]);
+		start = now();
+		for (unsigned int r=0; r < reps; r++)
+		{
+			unsigned long long int at = 0;
+			while (true)
+			{
+				unsigned long long int skip = skips.next(rng);
+				if (skip >= n - at) break;
+				at += skip;
+				sink += at;
+				at++;
+			};
+		};
+		double skipped = (now() - start) * 1e6 / reps;
+		ostringstream label;
+		label << labels[k] << " " << rates[k];
+		cout << setw(20) << label.str()
+			<< setw(14) << fixed << setprecision(2) << tested
+			<< setw(14) << setprecision(3) << skipped
+			<< setw(10) << setprecision(0) << tested / skipped << "x"
+			<< (sink == 1 ? " " : "") << endl;
+	};
+};
+
+int main(int argc, char* argv[])
+{
+	srand48(1);
+	int errors = check_engine() + check_buffer() + check_skip() 
+		+ check_repeat() + check_threads();
+	cout << "random engine check: " 
+		<< (errors ? "FAILED" : "passed") << endl;
+	if (argc > 1)
+	{
+		cout << setw(14) << "source" << setw(14) << "ns per gene"
+			<< setw(11) << "speedup" << endl;
+		timing();
+		cout << endl << setw(14) << "draw" << setw(14) << "engine ns"
+			<< setw(14) << "buffer ns" << setw(11) << "speedup" << endl;
+		draw_timing();
+		cout << endl << setw(20) << "mutation odds" << setw(14) 
+			<< "per trial us" << setw(14) << "skipping us" 
+			<< setw(11) << "speedup" << endl;
+		skip_timing();
+	};
+	return errors;
+};
@@ -0,0 +1,273 @@
+/***********************************************
+This file is part of the Rick's Generic GA Solver project (https://launchpad.net/ricks-ga).
+
+    Rick's Generic GA Solver is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Rick's Generic GA Solver is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Rick's Generic GA Solver.  If not, see <http://www.gnu.org/licenses/>.
+
+***********************************************/
+// recombine and splice test and timing program
+
+#include "basic_chromosome.h"
+#include <stdlib.h>
+#include <sys/time.h>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+
+using namespace std;
+
+typedef ricks_ga::basic_chromosome<unsigned char> chromosome;
+// the same genes held in the chromosome, up to 1024 of them.
+typedef ricks_ga::basic_chromosome<unsigned char,1024> fixed_chromosome;
+
+// reference: gene by gene through operator [], as the chromosome used to do.
+template <class C>
+void reference_recombine(C & a, C & b, 
+	unsigned int crossover, vector<unsigned char> & child)
+{
+	child.clear();
+	for (unsigned int i = 0; i < crossover; i++)
+	{
+		child.push_back(a[i]);
+	};
+	for (unsigned int i = crossover; i < b.length(); i++)
+	{
+		child.push_back(b[i]);
+	};
+};
+
+template <class C>
+void reference_splice(C & a, C & b, unsigned int start,
+	unsigned int end, vector<unsigned char> & child)
+{
+	child.clear();
+	bool reverse = start > end;
+	unsigned int astart = std::min(start,end);
+	unsigned int aend = std::max(start,end);
+	for (unsigned int i=0; i < astart; i++)
+	{
+		child.push_back(a[i]);
+	};
+	for (unsigned int i=0; i <= aend - astart; i++)
+	{
+		child.push_back(b[reverse ? (aend - i) : (astart + i)]);
+	};
+	for (unsigned int i = aend+1; i < a.length(); i++)
+	{
+		child.push_back(a[i]);
+	};
+};
+
+double now()
+{
+	timeval t;
+	gettimeofday(&t,0);
+	return t.tv_sec + t.tv_usec / 1e6;
+};
+
+template <class C>
+bool same(C & c, vector<unsigned char> & want)
+{
+	if (c.length() != want.size()) return false;
+	for (unsigned int i=0; i < want.size(); i++)
+	{
+		if (c[i] != want[i]) return false;
+	};
+	return true;
+};
+
+template <class C>
+int check()
+{
+	int errors = 0;
+	unsigned int sizes[] = {1,2,3,7,50,1000};
+	vector<unsigned char> want;
+	for (unsigned int s=0; s < sizeof(sizes)/sizeof(int); s++)
+	{
+		unsigned int n = sizes[s];
+		C a, b, child;
+		a.reload(n);
+		b.reload(n);
+		// a child that starts out longer and one that starts out shorter.
+		child.reload(n == 1 ? 3 : n / 2);
+		for (unsigned int t=0; t < 200; t++)
+		{
+			unsigned int x = lrand48() % n;
+			unsigned int y = lrand48() % n;
+			reference_splice(a,b,x,y,want);
+			child.splice(a,b,x,y);
+			if (!same(child,want))
+			{
+				cerr << "splice mismatch at n=" << n << ", " << x << "-" 
+					<< y << endl;
+				errors++;
+			};
+			reference_recombine(a,b,x,want);
+			child.recombine(a,b,x);
+			if (!same(child,want))
+			{
+				cerr << "recombine mismatch at n=" << n << ", " << x << endl;
+				errors++;
+			};
+			// a parent may be the child.
+			C c(a);
+			reference_splice(a,b,x,y,want);
+			c.splice(c,b,x,y);
+			if (!same(c,want)) errors++;
+			c = b;
+			reference_splice(a,b,x,y,want);
+			c.splice(a,c,x,y);
+			if (!same(c,want)) errors++;
+			c = a;
+			reference_recombine(a,b,x,want);
+			c.recombine(c,b,x);
+			if (!same(c,want)) errors++;
+			c = b;
+			reference_recombine(a,b,x,want);
+			c.recombine(a,c,x);
+			if (!same(c,want)) errors++;
+		};
+		// bad indices and lengths are still refused.
+		C shorter;
+		shorter.reload(n + 1);
+		unsigned int bad[][2] = {{n,0},{0,n},{n+5,n+7}};
+		for (unsigned int i=0; i < 3; i++)
+		{
+			try
+			{
+				child.splice(a,b,bad[i][0],bad[i][1]);
+				errors++;
+			}
+			catch (typename C::splice_error & e) {};
+		};
+		try
+		{
+			child.splice(a,shorter,0,0);
+			errors++;
+		}
+		catch (typename C::splice_error & e) {};
+		try
+		{
+			child.recombine(a,b,n);
+			errors++;
+		}
+		catch (typename C::recombine_error & e) {};
+	};
+	return errors;
+};
+
+// a fixed capacity chromosome refuses more genes than it holds.
+int check_capacity()
+{
+	int errors = 0;
+	fixed_chromosome c;
+	c.reload(1024);
+	try
+	{
+		c.reload(1);
+		errors++;
+	}
+	catch (fixed_chromosome::capacity_error & e) {};
+	vector<unsigned char> genes(1025,7);
+	try
+	{
+		c.load(&genes[0],1025);
+		errors++;
+	}
+	catch (fixed_chromosome::capacity_error & e) {};
+	c.load(&genes[0],10);
+	if ((c.length() != 10) || (c[9] != 7)) errors++;
+	return errors;
+};
+
+template <class C>
+void timing(const char * label, unsigned int largest)
+{
+	unsigned int sizes[] = {50,1000,100000};
+	for (unsigned int s=0; s < sizeof(sizes)/sizeof(int); s++)
+	{
+		unsigned int n = sizes[s];
+		if (n > largest) break;
+		unsigned int reps = 200000000 / n;
+		C a, b, child;
+		a.reload(n);
+		b.reload(n);
+		vector<unsigned int> points(1024);
+		for (unsigned int i=0; i < points.size(); i++)
+		{
+			points[i] = lrand48() % n;
+		};
+		vector<unsigned char> old_child;
+		unsigned long long int sink = 0;
+		double ns[5];
+		// copies into new chromosomes, as the population is copied into
+		// the next generation and the sorted maps.
+		vector<C> copies;
+		copies.reserve(64);
+		for (int k=0; k < 5; k++)
+		{
+			double start = now();
+			for (unsigned int r=0; r < reps; r++)
+			{
+				unsigned int x = points[r % 1024];
+				unsigned int y = points[(r + 1) % 1024];
+				switch (k)
+				{
+					case 0: reference_splice(a,b,x,y,old_child); break;
+					case 1: child.splice(a,b,x,y); break;
+					case 2: reference_recombine(a,b,x,old_child); break;
+					case 3: child.recombine(a,b,x); break;
+					default: 
+						if (copies.size() == 64) copies.clear();
+						copies.push_back((r % 2) ? a : b);
+						break;
+				};
+				sink += (k == 4) ? copies.back()[0] 
+					: (k % 2) ? child[0] : old_child[0];
+			};
+			ns[k] = (now() - start) * 1e9 / reps;
+		};
+		cout << setw(8) << label << setw(8) << "splice" << setw(8) << n
+			<< setw(14) << fixed << setprecision(1) << ns[0]
+			<< setw(14) << ns[1]
+			<< setw(10) << setprecision(2) << ns[0] / ns[1] << "x"
+			<< endl;
+		cout << setw(8) << label << setw(8) << "cross" << setw(8) << n
+			<< setw(14) << fixed << setprecision(1) << ns[2]
+			<< setw(14) << ns[3]
+			<< setw(10) << setprecision(2) << ns[2] / ns[3] << "x"
+			<< endl;
+		cout << setw(8) << label << setw(8) << "copy" << setw(8) << n
+			<< setw(28) << setprecision(1) << ns[4]
+			<< (sink == 1 ? " " : "")
+			<< endl;
+	};
+};
+
+int main(int argc, char* argv[])
+{
+	srand48(1);
+	// the error messages for the refused calls are expected.
+	int errors = check<chromosome>() + check<fixed_chromosome>() + check_capacity();
+	cout << "recombine/splice check: " 
+		<< (errors ? "FAILED" : "passed") << endl;
+	if (argc > 1)
+	{
+		cout << setw(8) << "storage" << setw(8) << "method" << setw(8) << "n"
+			<< setw(14) << "per gene ns" << setw(14) << "bulk ns"
+			<< setw(11) << "speedup" << endl;
+		timing<chromosome>("vector", 100000);
+		timing<fixed_chromosome>("inline", 1024);
+	};
+	return errors;
+};
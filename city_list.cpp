@@ -0,0 +1,260 @@
+/***********************************************
+This file is part of the Rick's Generic GA Solver project (https://launchpad.net/ricks-ga).
+
+    Rick's Generic GA Solver is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Rick's Generic GA Solver is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Rick's Generic GA Solver.  If not, see <http://www.gnu.org/licenses/>.
+
+***********************************************/
+/* 
+	city list storage
+*/
+
+#include <fstream>
+#include <iostream>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <triad.h>
+#include "city_list.h"
+
+using namespace std;
+
+namespace
+{
+	const char magic[8] = {'R','G','A','C','I','T','Y','S'};
+	const unsigned int version = 1;
+	
+	// rounds offset up to the next 64 byte boundary.
+	unsigned long long int align(unsigned long long int offset)
+	{
+		return (offset + 63) & ~63ULL;
+	};
+
+	void fail(const string & filename, const string & why)
+	{
+		cerr << __FILE__ << "|" << __FUNCTION__ << "|" << __LINE__ 
+			<< ": " << filename << ": " << why << endl;
+		exit(1);
+	};
+};
+
+city_list::city_list()
+{
+	mapping = 0;
+	mapping_size = 0;
+	clear();
+};
+
+city_list::~city_list()
+{
+	clear();
+};
+
+void city_list::clear()
+{
+	if (mapping)
+	{
+		munmap(mapping, mapping_size);
+		mapping = 0;
+		mapping_size = 0;
+	};
+	own_x.clear();
+	own_y.clear();
+	own_z.clear();
+	own_index.assign(1,0);
+	own_text.clear();
+	point_at_own();
+};
+
+void city_list::point_at_own()
+{
+	count = own_x.size();
+	xs = own_x.data();
+	ys = own_y.data();
+	zs = own_z.data();
+	index = own_index.data();
+	text = own_text.data();
+};
+
+void city_list::load(const string & filename)
+{
+	if (is_binary(filename))
+	{
+		map(filename);
+	}
+	else
+	{
+		read_text(filename);
+	};
+};
+
+void city_list::read_text(const string & filename)
+{
+	clear();
+	ifstream infile(filename.c_str());
+	string name;
+	nrtb::triad<float> loc;
+	while (infile >> name >> loc)
+	{
+		own_x.push_back(loc.x);
+		own_y.push_back(loc.y);
+		own_z.push_back(loc.z);
+		own_text += name;
+		own_index.push_back(own_text.size());
+	};
+	infile.close();
+	point_at_own();
+};
+
+bool city_list::is_binary(const string & filename)
+{
+	char start[sizeof(magic)];
+	ifstream infile(filename.c_str(), ios::binary);
+	if (!infile.read(start, sizeof(start))) return false;
+	return memcmp(start, magic, sizeof(magic)) == 0;
+};
+
+void city_list::map(const string & filename)
+{
+	clear();
+	int fd = open(filename.c_str(), O_RDONLY);
+	if (fd < 0) fail(filename, "unable to open.");
+	struct stat info;
+	if ((fstat(fd, &info) != 0) || (info.st_size < (off_t) sizeof(binary_header)))
+	{
+		close(fd);
+		fail(filename, "too short to be a binary city file.");
+	};
+	void * block = mmap(0, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (block == MAP_FAILED) fail(filename, "unable to map.");
+	mapping = block;
+	mapping_size = info.st_size;
+	const char * base = (const char *) block;
+	const binary_header * h = (const binary_header *) base;
+	// sanity checks before anything is used.
+	if (memcmp(h->magic, magic, sizeof(magic)) != 0)
+	{
+		fail(filename, "not a binary city file.");
+	};
+	if (h->version != version)
+	{
+		fail(filename, "unknown version or written with another byte order.");
+	};
+	unsigned long long int n = h->count;
+	unsigned long long int floats = n * sizeof(float);
+	unsigned long long int offsets = (n + 1) * sizeof(unsigned long long int);
+	if ((h->size != mapping_size)
+		|| (h->x % 64) || (h->y % 64) || (h->z % 64) || (h->index % 64)
+		|| (h->x + floats > h->size) || (h->y + floats > h->size)
+		|| (h->z + floats > h->size) || (h->index + offsets > h->size)
+		|| (h->text > h->size))
+	{
+		fail(filename, "damaged binary city file.");
+	};
+	const unsigned long long int * names = 
+		(const unsigned long long int *) (base + h->index);
+	bool ordered = (names[0] == 0) && (h->text + names[n] <= h->size);
+	for (unsigned long long int i=0; ordered && (i < n); i++)
+	{
+		ordered = names[i] <= names[i+1];
+	};
+	if (!ordered) fail(filename, "damaged name index.");
+	count = n;
+	xs = (const float *) (base + h->x);
+	ys = (const float *) (base + h->y);
+	zs = (const float *) (base + h->z);
+	index = names;
+	text = base + h->text;
+};
+
+void city_list::write(const string & filename)
+{
+	binary_header h;
+	memset(&h, 0, sizeof(h));
+	memcpy(h.magic, magic, sizeof(magic));
+	h.version = version;
+	h.count = count;
+	unsigned long long int floats = (unsigned long long int) count * sizeof(float);
+	h.x = align(sizeof(h));
+	h.y = align(h.x + floats);
+	h.z = align(h.y + floats);
+	h.index = align(h.z + floats);
+	h.text = align(h.index + (count + 1ULL) * sizeof(unsigned long long int));
+	h.size = h.text + index[count];
+	// written under a temporary name and renamed into place.
+	string temp = filename + ".XXXXXX";
+	vector<char> name(temp.begin(), temp.end());
+	name.push_back(0);
+	int fd = mkstemp(&name[0]);
+	if (fd < 0) fail(filename, "unable to create a temporary file.");
+	fchmod(fd, 0644);
+	close(fd);
+	ofstream out(&name[0], ios::binary | ios::trunc);
+	const char zeros[64] = {0};
+	unsigned long long int at = 0;
+	// writes length bytes from data starting at offset, padding up to it.
+	auto put = [&](unsigned long long int offset, const void * data,
+		unsigned long long int length)
+	{
+		out.write(zeros, offset - at);
+		out.write((const char *) data, length);
+		at = offset + length;
+	};
+	put(0, &h, sizeof(h));
+	put(h.x, xs, floats);
+	put(h.y, ys, floats);
+	put(h.z, zs, floats);
+	put(h.index, index, (count + 1ULL) * sizeof(unsigned long long int));
+	put(h.text, text, index[count]);
+	out.close();
+	if (!out || (rename(&name[0], filename.c_str()) != 0))
+	{
+		unlink(&name[0]);
+		fail(filename, "unable to write.");
+	};
+};
+
+unsigned int city_list::size() const
+{
+	return count;
+};
+
+bool city_list::mapped() const
+{
+	return mapping != 0;
+};
+
+const float * city_list::x() const
+{
+	return xs;
+};
+
+const float * city_list::y() const
+{
+	return ys;
+};
+
+const float * city_list::z() const
+{
+	return zs;
+};
+
+string city_list::name(unsigned int i) const
+{
+	return string(text + index[i], index[i+1] - index[i]);
+};
@@ -0,0 +1,118 @@
+/***********************************************
+This file is part of the Rick's Generic GA Solver project (https://launchpad.net/ricks-ga).
+
+    Rick's Generic GA Solver is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Rick's Generic GA Solver is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Rick's Generic GA Solver.  If not, see <http://www.gnu.org/licenses/>.
+
+***********************************************/
+/* 
+	city list storage
+*/
+
+#ifndef city_list_h
+#define city_list_h
+
+#include <string>
+#include <vector>
+
+/** The cities of a world: a name and x,y,z coordinates for each.
+ ** 
+ ** Cities are read from either of two formats. The text format is the 
+ ** original one: one city per line, a name followed by "x,y,z". The 
+ ** binary format is laid out so it can be used in place once mapped 
+ ** into memory, with nothing parsed or copied:
+ ** 
+ ** 	header		see binary_header below.
+ ** 	x, y, z		count floats each.
+ ** 	name index	count+1 64 bit offsets into the name text; name i
+ ** 			runs from index[i] up to index[i+1].
+ ** 	name text	the names, back to back with no terminators.
+ ** 
+ ** Every section starts on a 64 byte boundary. Numbers are stored in 
+ ** the byte order of the machine that wrote the file, which is checked
+ ** when it is mapped.
+ ** 
+ ** The coordinates are handed out as one array per axis, which is the 
+ ** form the fitness kernels want.
+ **/
+class city_list
+{
+	public:
+		/// Leading block of a binary city file.
+		struct binary_header
+		{
+			char magic[8];
+			unsigned int version;
+			unsigned int count;
+			// byte offsets of the sections from the start of the file.
+			unsigned long long int x;
+			unsigned long long int y;
+			unsigned long long int z;
+			unsigned long long int index;
+			unsigned long long int text;
+			// total length of the file.
+			unsigned long long int size;
+		};
+		city_list();
+		~city_list();
+		/** Loads filename in whichever format it is in.
+		 ** 
+		 ** Binary files are mapped, text files are parsed.
+		 **/
+		void load(const std::string & filename);
+		/// Parses a text city list.
+		void read_text(const std::string & filename);
+		/** Maps a binary city file.
+		 ** 
+		 ** The program exits with a message if filename is not a valid 
+		 ** binary city file.
+		 **/
+		void map(const std::string & filename);
+		/// True if filename starts like a binary city file.
+		static bool is_binary(const std::string & filename);
+		/** Writes the cities to filename in the binary format.
+		 ** 
+		 ** The file is written under a temporary name and renamed into 
+		 ** place, so a reader never sees a partial file.
+		 **/
+		void write(const std::string & filename);
+		/// Discards all the cities.
+		void clear();
+		/// Number of cities.
+		unsigned int size() const;
+		/// True if the cities are mapped from a binary file.
+		bool mapped() const;
+		const float * x() const;
+		const float * y() const;
+		const float * z() const;
+		/// Name of city i.
+		std::string name(unsigned int i) const;
+	private:
+		unsigned int count;
+		const float * xs;
+		const float * ys;
+		const float * zs;
+		const unsigned long long int * index;
+		const char * text;
+		// storage for parsed lists.
+		std::vector<float> own_x, own_y, own_z;
+		std::vector<unsigned long long int> own_index;
+		std::string own_text;
+		// the mapping, if any.
+		void * mapping;
+		size_t mapping_size;
+		void point_at_own();
+		city_list(const city_list &);
+};
+
+#endif // city_list_h
@@ -20,6 +20,7 @@ This file is part of the Rick's Generic GA Solver project (https://launchpad.net
 #include <iostream>
 #include <math.h>
 #include <time.h>
+#include <fstream>
 #include "common.h"
 
 using namespace std;
@@ -270,5 +271,20 @@ string http_unhex(string s)
    return s;
 };// string unhex()
 
+unsigned long int resident_kb()
+{
+	ifstream status("/proc/self/status");
+	string field;
+	while (status >> field)
+	{
+		if (field == "VmRSS:")
+		{
+			unsigned long int returnme = 0;
+			status >> returnme;
+			return returnme;
+		};
+	};
+	return 0;
+};
 
 } // namespace nrtb
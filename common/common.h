@@ -167,5 +167,11 @@ std::string http_enhex(const std::string &s);
  **/
 std::string http_unhex(std::string s);
 
+/** Returns the resident memory of this process in kilobytes.
+ ** 
+ ** Read from /proc/self/status; returns 0 where that is not available.
+ **/
+unsigned long int resident_kb();
+
 } // namespace nrtb
 #endif /* __ga_common_h */ 
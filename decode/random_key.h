@@ -0,0 +1,255 @@
+/***********************************************
+This file is part of the Rick's Generic GA Solver project (https://launchpad.net/ricks-ga).
+
+    Rick's Generic GA Solver is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Rick's Generic GA Solver is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Rick's Generic GA Solver.  If not, see <http://www.gnu.org/licenses/>.
+
+***********************************************/
+/* random_key.h - decodes random key chromosomes into visiting orders.
+*/
+
+#ifndef random_key_h
+#define random_key_h
+
+#include <algorithm>
+
+namespace ricks_ga
+{
+
+/** Comparator lists for Batcher odd-even merge sorts of 0 to SIZE keys.
+ ** 
+ ** Built from the SIZE input network by dropping every comparator that 
+ ** touches a position >= n; those would only ever compare against 
+ ** padding that sorts last anyway.
+ **/
+template <unsigned int SIZE>
+struct network_table
+{
+	unsigned char low[SIZE+1][SIZE * SIZE];
+	unsigned char high[SIZE+1][SIZE * SIZE];
+	unsigned int count[SIZE+1];
+	network_table()
+	{
+		for (unsigned int n = 0; n <= SIZE; n++)
+		{
+			count[n] = 0;
+			for (unsigned int p = 1; p < SIZE; p <<= 1)
+			{
+				for (unsigned int k = p; k >= 1; k >>= 1)
+				{
+					for (unsigned int j = k % p; j + k < SIZE; j += 2*k)
+					{
+						for (unsigned int i = 0; i < k; i++)
+						{
+							if (((i + j) / (2*p) == (i + j + k) / (2*p))
+								&& (i + j + k < n))
+							{
+								low[n][count[n]] = i + j;
+								high[n][count[n]] = i + j + k;
+								count[n]++;
+							};
+						};
+					};
+				};
+			};
+		};
+	};
+};
+
+/** Random key decoder.
+ ** 
+ ** A random key chromosome describes an ordering: gene i is the sort key 
+ ** of item i, and the items are visited in ascending key order. Equal 
+ ** keys are visited in item order, so every decoder here is a stable
+ ** sort of the item indexes by gene value.
+ ** 
+ ** The sort used is picked at compile time from the width of the gene
+ ** type G:
+ ** 
+ ** 1. n <= network_limit (any gene up to 32 bits): a fixed sorting 
+ **    network on packed (gene,index) keys; no branches on the data.
+ ** 
+ ** 2. 8 bit genes: a single 256 bucket counting sort, O(n) with no 
+ **    comparisons at all.
+ ** 
+ ** 3. Wider genes: an LSD radix sort, one 8 bit digit per pass. Passes
+ **    where every key has the same digit are skipped. Below radix_limit
+ **    items the passes cost more than they save and an in place 
+ **    std::sort of packed keys is used instead.
+ ** 
+ ** genes may be anything that supports genes[i] for i in 0..n-1 (a raw
+ ** pointer or a basic_chromosome, for example). order must point to at
+ ** least n unsigned ints and work to at least n unsigned long long ints;
+ ** on return order holds the item indexes in visiting order. Nothing is
+ ** allocated.
+ **/
+template <class G, unsigned int W = sizeof(G)>
+struct random_key
+{
+	/// largest n handed to the sorting network.
+	static const unsigned int network_limit = (W <= 4) ? 12 : 0;
+	/// smallest n handed to the radix sort.
+	static const unsigned int radix_limit = 
+		(W <= 2) ? 64 : ((W <= 4) ? 2048 : 0);
+
+	template <class S>
+	static void decode(S & genes, unsigned int n, unsigned int * order, 
+		unsigned long long int * work)
+	{
+		if (n <= network_limit)
+		{
+			network(genes,n,order);
+		}
+		else if (n < radix_limit)
+		{
+			packed(genes,n,order,work);
+		}
+		else
+		{
+			radix(genes,n,order,(unsigned int *) work);
+		};
+	};
+
+	/// Comparison sort of packed (gene,index) keys.
+	template <class S>
+	static void packed(S & genes, unsigned int n, unsigned int * order,
+		unsigned long long int * keys)
+	{
+		for (unsigned int i=0; i < n; i++)
+		{
+			keys[i] = ((unsigned long long int) genes[i] << 32) | i;
+		};
+		std::sort(keys, keys + n);
+		for (unsigned int i=0; i < n; i++)
+		{
+			order[i] = (unsigned int) keys[i];
+		};
+	};
+
+	/// Batcher odd-even merge sort on packed keys; branch free.
+	template <class S>
+	static void network(S & genes, unsigned int n, unsigned int * order)
+	{
+		static const network_table<16> table;
+		unsigned long long int keys[16];
+		for (unsigned int i=0; i < n; i++)
+		{
+			keys[i] = ((unsigned long long int) genes[i] << 32) | i;
+		};
+		const unsigned char * low = table.low[n];
+		const unsigned char * high = table.high[n];
+		for (unsigned int c=0; c < table.count[n]; c++)
+		{
+			unsigned long long int a = keys[low[c]];
+			unsigned long long int b = keys[high[c]];
+			unsigned long long int lo = a < b ? a : b;
+			keys[low[c]] = lo;
+			keys[high[c]] = a ^ b ^ lo;
+		};
+		for (unsigned int i=0; i < n; i++)
+		{
+			order[i] = (unsigned int) keys[i];
+		};
+	};
+
+	/// LSD radix sort, 8 bits per pass.
+	template <class S>
+	static void radix(S & genes, unsigned int n, unsigned int * order,
+		unsigned int * work)
+	{
+		unsigned int * src = order;
+		unsigned int * dst = work;
+		for (unsigned int i=0; i < n; i++)
+		{
+			src[i] = i;
+		};
+		for (unsigned int shift = 0; shift < W * 8; shift += 8)
+		{
+			unsigned int counts[256];
+			std::fill(counts, counts + 256, 0);
+			for (unsigned int i=0; i < n; i++)
+			{
+				counts[((unsigned long long int) genes[i] >> shift) & 0xff]++;
+			};
+			// nothing moves if every key shares this digit.
+			unsigned int first = ((unsigned long long int) genes[0] >> shift) & 0xff;
+			if (counts[first] == n) continue;
+			unsigned int total = 0;
+			for (unsigned int d=0; d < 256; d++)
+			{
+				unsigned int c = counts[d];
+				counts[d] = total;
+				total += c;
+			};
+			for (unsigned int i=0; i < n; i++)
+			{
+				unsigned int item = src[i];
+				dst[counts[((unsigned long long int) genes[item] >> shift) & 0xff]++] 
+					= item;
+			};
+			std::swap(src,dst);
+		};
+		if (src != order)
+		{
+			std::copy(src, src + n, order);
+		};
+	};
+};
+
+/// 8 bit genes need only a single counting sort pass.
+template <class G>
+struct random_key<G,1>
+{
+	static const unsigned int network_limit = 12;
+
+	template <class S>
+	static void decode(S & genes, unsigned int n, unsigned int * order, 
+		unsigned long long int * /*work*/)
+	{
+		if (n <= network_limit)
+		{
+			random_key<G,2>::network(genes,n,order);
+		}
+		else
+		{
+			counting(genes,n,order);
+		};
+	};
+
+	/// 256 bucket counting sort; stable, so ties stay in item order.
+	template <class S>
+	static void counting(S & genes, unsigned int n, unsigned int * order)
+	{
+		unsigned int counts[256];
+		std::fill(counts, counts + 256, 0);
+		for (unsigned int i=0; i < n; i++)
+		{
+			counts[(unsigned char) genes[i]]++;
+		};
+		unsigned int total = 0;
+		for (unsigned int d=0; d < 256; d++)
+		{
+			unsigned int c = counts[d];
+			counts[d] = total;
+			total += c;
+		};
+		for (unsigned int i=0; i < n; i++)
+		{
+			order[counts[(unsigned char) genes[i]]++] = i;
+		};
+	};
+};
+
+} // namespace ricks_ga
+
+#endif // random_key_h
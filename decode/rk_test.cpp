@@ -0,0 +1,148 @@
+/***********************************************
+This file is part of the Rick's Generic GA Solver project (https://launchpad.net/ricks-ga).
+
+    Rick's Generic GA Solver is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Rick's Generic GA Solver is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Rick's Generic GA Solver.  If not, see <http://www.gnu.org/licenses/>.
+
+***********************************************/
+
+// random key decoder test and timing program
+
+#include "random_key.h"
+#include <stdlib.h>
+#include <sys/time.h>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+
+using namespace std;
+
+// reference: packed keys through std::sort, as world used to do.
+template <class G>
+void reference(const G * genes, unsigned int n, unsigned int * order,
+	unsigned long long int * keys)
+{
+	for (unsigned int i=0; i < n; i++)
+	{
+		keys[i] = ((unsigned long long int) genes[i] << 32) | i;
+	};
+	sort(keys, keys + n);
+	for (unsigned int i=0; i < n; i++)
+	{
+		order[i] = (unsigned int) keys[i];
+	};
+};
+
+double now()
+{
+	timeval t;
+	gettimeofday(&t,0);
+	return t.tv_sec + t.tv_usec / 1e6;
+};
+
+template <class G>
+int check(const char * label)
+{
+	int errors = 0;
+	unsigned int sizes[] = {1,2,3,7,15,16,17,50,63,64,255,256,1000,2047,2048,5000};
+	// narrow ranges force plenty of ties.
+	unsigned long int ranges[] = {2,16,256,65536,0};
+	for (unsigned int s=0; s < sizeof(sizes)/sizeof(int); s++)
+	{
+		unsigned int n = sizes[s];
+		vector<G> genes(n);
+		vector<unsigned int> got(n), want(n);
+		vector<unsigned long long int> work(n);
+		vector<unsigned long long int> keys(n);
+		for (unsigned int r=0; r < sizeof(ranges)/sizeof(long); r++)
+		{
+			for (unsigned int i=0; i < n; i++)
+			{
+				genes[i] = ranges[r] ? lrand48() % ranges[r] : lrand48();
+			};
+			const G * g = &genes[0];
+			ricks_ga::random_key<G>::decode(g,n,&got[0],&work[0]);
+			reference(g,n,&want[0],&keys[0]);
+			if (got != want)
+			{
+				cerr << label << ": mismatch at n=" << n 
+					<< ", range=" << ranges[r] << endl;
+				errors++;
+			};
+		};
+	};
+	return errors;
+};
+
+template <class G>
+void timing(const char * label)
+{
+	unsigned int sizes[] = {10,12,16,50,250,1000,10000};
+	for (unsigned int s=0; s < sizeof(sizes)/sizeof(int); s++)
+	{
+		unsigned int n = sizes[s];
+		unsigned int reps = 20000000 / n;
+		vector<G> genes(n);
+		vector<unsigned int> order(n);
+		vector<unsigned long long int> work(n);
+		vector<unsigned long long int> keys(n);
+		for (unsigned int i=0; i < n; i++)
+		{
+			genes[i] = lrand48();
+		};
+		const G * g = &genes[0];
+		unsigned long long int sink = 0;
+		double start = now();
+		for (unsigned int r=0; r < reps; r++)
+		{
+			genes[r % n] ^= r;
+			reference(g,n,&order[0],&keys[0]);
+			sink += order[0];
+		};
+		double old_ns = (now() - start) * 1e9 / reps;
+		start = now();
+		for (unsigned int r=0; r < reps; r++)
+		{
+			genes[r % n] ^= r;
+			ricks_ga::random_key<G>::decode(g,n,&order[0],&work[0]);
+			sink += order[0];
+		};
+		double new_ns = (now() - start) * 1e9 / reps;
+		cout << setw(8) << label << setw(8) << n
+			<< setw(14) << fixed << setprecision(1) << old_ns
+			<< setw(14) << new_ns
+			<< setw(10) << setprecision(2) << old_ns / new_ns << "x"
+			<< (sink == 1 ? " " : "")
+			<< endl;
+	};
+};
+
+int main(int argc, char* argv[])
+{
+	srand48(1);
+	int errors = check<unsigned char>("8 bit")
+		+ check<unsigned short>("16 bit")
+		+ check<unsigned int>("32 bit");
+	cout << "random_key decode check: " 
+		<< (errors ? "FAILED" : "passed") << endl;
+	if (argc > 1)
+	{
+		cout << setw(8) << "gene" << setw(8) << "n"
+			<< setw(14) << "std::sort ns" << setw(14) << "decode ns"
+			<< setw(11) << "speedup" << endl;
+		timing<unsigned char>("8 bit");
+		timing<unsigned short>("16 bit");
+		timing<unsigned int>("32 bit");
+	};
+	return errors;
+};
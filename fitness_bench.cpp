@@ -0,0 +1,379 @@
+/***********************************************
+This file is part of the Rick's Generic GA Solver project (https://launchpad.net/ricks-ga).
+
+    Rick's Generic GA Solver is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Rick's Generic GA Solver is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Rick's Generic GA Solver.  If not, see <http://www.gnu.org/licenses/>.
+
+***********************************************/
+/*
+	fitness evaluation benchmark.
+
+	Reports chromosome evaluations per second for each of the supplied
+	city lists (and a generated 1,000 city instance) with and without
+	the precomputed distance table, one chromosome at a time and through
+	each of the batch kernels the CPU supports. The batch results are 
+	checked against the single chromosome ones. The "lengths" rows time
+	the kernels alone on tours that were decoded up front. The tables are
+	also tried quantized to 16 and 32 bits (see world::quantize()), with
+	their size and the largest difference seen between the lengths they
+	give and the lengths added up in double precision. The bound is 
+	world::quantization_error(); float sums carry rounding error too.
+
+	The "locality" rows time the kernel on greedy nearest neighbor tours
+	(good tours step between nearby cities) and on random tours, with 
+	the cities numbered in input order and along the Morton and Hilbert 
+	curves (see world::renumber()), on a generated instance of 
+	locality cities without a distance table and one small enough for
+	a table. The speedups are relative to input order.
+
+	usage: fitness_bench [seconds=n] [generated=n] [locality=n] 
+		[list files...]
+*/
+
+// library includes.
+#include <vector>
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <stdlib.h>
+#include <unistd.h>
+#include <confreader.h>
+#include <hires_timer.h>
+// local includes.
+#include "chromosome.h"
+#include "fitness_tester.h"
+
+using namespace std;
+
+typedef vector<chromosome> c_vector;
+
+// writes a random instance of count cities and returns the file name.
+string make_instance(unsigned int count)
+{
+	char name[] = "/tmp/fitness_bench_XXXXXX";
+	int fd = mkstemp(name);
+	if (fd < 0)
+	{
+		cerr << "unable to create a temporary city list." << endl;
+		exit(1);
+	};
+	close(fd);
+	ofstream out(name);
+	for (unsigned int i=0; i < count; i++)
+	{
+		out << "g" << i << "\t"
+			<< (lrand48() % 1000) - 500 << ","
+			<< (lrand48() % 1000) - 500 << ","
+			<< (lrand48() % 1000) - 500 << endl;
+	};
+	out.close();
+	return name;
+};
+
+// the ways chromosomes can be scored.
+enum eval_mode { single, batch };
+
+// evaluations per second over the supplied population.
+double rate(world & w, c_vector & pop, eval_mode mode, double seconds)
+{
+	unsigned long long evals = 0;
+	float sink = 0;
+	decode_buffer buffer;
+	nrtb::hirez_timer clock;
+	while (clock.interval() < seconds)
+	{
+		if (mode == single)
+		{
+			for (unsigned int i=0; i < pop.size(); i++)
+			{
+				sink += w.check_fitness(pop[i],buffer);
+			};
+		}
+		else
+		{
+			w.check_fitness(&pop[0],pop.size(),buffer);
+			sink += pop[0].fitness;
+		};
+		evals += pop.size();
+	};
+	double elapsed = clock.stop();
+	// keep the optimizer honest.
+	if (sink == 1.0) cerr << "";
+	return evals / elapsed;
+};
+
+// tour lengths per second from the kernel alone.
+double kernel_rate(world & w, vector<unsigned int> & tours, 
+	unsigned int count, double seconds)
+{
+	unsigned long long evals = 0;
+	vector<float> lengths(count);
+	float sink = 0;
+	nrtb::hirez_timer clock;
+	while (clock.interval() < seconds)
+	{
+		w.tour_lengths(&tours[0], count, &lengths[0]);
+		sink += lengths[0];
+		evals += count;
+	};
+	double elapsed = clock.stop();
+	if (sink == 1.0) cerr << "";
+	return evals / elapsed;
+};
+
+// number of chromosomes whose fitness differs from the reference.
+unsigned int differences(c_vector & pop, vector<float> & reference)
+{
+	unsigned int returnme = 0;
+	for (unsigned int i=0; i < pop.size(); i++)
+	{
+		if (pop[i].fitness != reference[i]) returnme++;
+	};
+	return returnme;
+};
+
+void report(const string & label, int n, const string & mode, double r,
+	double base, unsigned int wrong)
+{
+	cout << setw(20) << label
+		<< setw(8) << n
+		<< setw(24) << mode
+		<< setw(14) << fixed << setprecision(0) << r
+		<< setw(10) << setprecision(2) << r / base << "x";
+	if (wrong) cout << "  " << wrong << " MISMATCHED";
+	cout << endl;
+};
+
+void run(const string & label, const string & filename, double seconds)
+{
+	world & w = world::get_instance();
+	// the same chromosomes are used for every run.
+	w.load(filename, false);
+	int n = w.length();
+	c_vector pop(std::max(1, 100000 / std::max(n,1)));
+	for (unsigned int i=0; i < pop.size(); i++)
+	{
+		pop[i].reload(n);
+	};
+	// decoded copies of the population for the kernel only runs.
+	vector<unsigned int> tours(pop.size() * n);
+	vector<unsigned long long int> work(n);
+	for (unsigned int i=0; i < pop.size(); i++)
+	{
+		const genetype * genes = pop[i].data();
+		ricks_ga::random_key<genetype>::decode(genes, n, &tours[i * n], 
+			&work[0]);
+	};
+	kernel_type kernels[] = {scalar_kernel, avx2_kernel, avx512_kernel};
+	// direct, then float, 16 and 32 bit tables.
+	const unsigned int bits[] = {0, 0, 16, 32};
+	const char * storages[] = {"direct", "table", "table16", "table32"};
+	double base = 0;
+	// the tour lengths added up in double precision.
+	vector<double> exact(pop.size(), 0);
+	w.load(filename, false);
+	for (unsigned int i=0; i < pop.size(); i++)
+	{
+		const unsigned int * tour = &tours[i * n];
+		for (int c=0; c < n; c++)
+		{
+			exact[i] += w.distance(tour[c], tour[(c + 1) % n]);
+		};
+	};
+	for (int s=0; s < 4; s++)
+	{
+		bool table = (s > 0);
+		w.quantize(bits[s]);
+		w.load(filename, table);
+		// worlds past world::table_limit never get a table.
+		if (table && !w.has_table()) continue;
+		string storage = storages[s];
+		w.use_kernel(scalar_kernel);
+		double r = rate(w, pop, single, seconds);
+		if (base == 0) base = r;
+		vector<float> reference(pop.size());
+		for (unsigned int i=0; i < pop.size(); i++)
+		{
+			reference[i] = pop[i].fitness;
+		};
+		report(label, n, "single/" + storage, r, base, 0);
+		// random chromosomes are mostly dead, so compare decoded tours.
+		vector<float> lengths(pop.size());
+		w.tour_lengths(&tours[0], pop.size(), &lengths[0]);
+		double error = 0;
+		for (unsigned int i=0; i < pop.size(); i++)
+		{
+			error = std::max(error, fabs(lengths[i] - exact[i]));
+		};
+		cout << setw(52) << storage + ": " 
+			<< setprecision(1) << w.table_bytes() / 1024.0 << "KB, error " 
+			<< setprecision(4) << error << " (bound " 
+			<< w.quantization_error() << ")" << endl;
+		for (int k=0; k < 3; k++)
+		{
+			kernel_type used = w.use_kernel(kernels[k]);
+			if (used != kernels[k]) continue;
+			r = rate(w, pop, batch, seconds);
+			report(label, n, string("batch/") + kernel_name(used) + "/" + storage,
+				r, base, differences(pop, reference));
+		};
+		double kbase = 0;
+		for (int k=0; k < 3; k++)
+		{
+			kernel_type used = w.use_kernel(kernels[k]);
+			if (used != kernels[k]) continue;
+			double r = kernel_rate(w, tours, pop.size(), seconds);
+			if (kbase == 0) kbase = r;
+			report(label, n, string("lengths/") + kernel_name(used) + "/" + storage,
+				r, kbase, 0);
+		};
+	};
+	w.quantize(0);
+	w.use_kernel(best_kernel);
+};
+
+// a greedy nearest neighbor tour from first, by original city number.
+vector<unsigned int> greedy_tour(world & w, unsigned int first)
+{
+	unsigned int n = w.length();
+	vector<unsigned int> returnme;
+	vector<bool> visited(n,false);
+	const unsigned int * along = w.spatial_order();
+	unsigned int scan = 0;
+	unsigned int at = first;
+	while (true)
+	{
+		returnme.push_back(at);
+		visited[at] = true;
+		if (returnme.size() == n) break;
+		// the nearest unvisited neighbor, else the next city along the 
+		// space filling curve.
+		unsigned int next = n;
+		const unsigned int * near = w.nearest(at);
+		for (unsigned int k=0; (k < w.neighbor_count()) && (next == n); k++)
+		{
+			if (!visited[near[k]]) next = near[k];
+		};
+		while (next == n)
+		{
+			if (!visited[along[scan]]) next = along[scan];
+			scan++;
+		};
+		at = next;
+	};
+	return returnme;
+};
+
+void locality(const string & label, const string & filename, bool table,
+	double seconds)
+{
+	world & w = world::get_instance();
+	const unsigned int tour_count = 16;
+	w.renumber(world::input_numbering);
+	w.load(filename, table);
+	if (table && !w.has_table()) return;
+	unsigned int n = w.length();
+	string storage = table ? "table" : "direct";
+	// the same tours, by original city number, for every numbering.
+	vector< vector<unsigned int> > good;
+	vector< vector<unsigned int> > random;
+	for (unsigned int t=0; t < tour_count; t++)
+	{
+		good.push_back(greedy_tour(w, lrand48() % n));
+		vector<unsigned int> shuffled(good.back());
+		random_shuffle(shuffled.begin(), shuffled.end());
+		random.push_back(shuffled);
+	};
+	world::numbering_type types[] = {world::input_numbering, 
+		world::morton_numbering, world::hilbert_numbering};
+	const char * names[] = {"input", "morton", "hilbert"};
+	double base[2] = {0, 0};
+	for (int t=0; t < 3; t++)
+	{
+		w.renumber(types[t]);
+		w.load(filename, table);
+		for (int kind=0; kind < 2; kind++)
+		{
+			vector< vector<unsigned int> > & source = kind ? random : good;
+			vector<unsigned int> tours(tour_count * n);
+			for (unsigned int i=0; i < tour_count; i++)
+			{
+				for (unsigned int c=0; c < n; c++)
+				{
+					tours[i * n + c] = w.internal_city(source[i][c]);
+				};
+			};
+			double r = kernel_rate(w, tours, tour_count, seconds);
+			if (t == 0) base[kind] = r;
+			report(label, n, string(kind ? "random/" : "greedy/") + names[t]
+				+ "/" + storage, r, base[kind], 0);
+		};
+	};
+	w.renumber(world::input_numbering);
+};
+
+int main(int argc, char* argv[])
+{
+	ricks_ga::conf_reader config;
+	config.read(argc,argv,"");
+	double seconds = config.get<double>("seconds",1.0);
+	unsigned int generated = config.get<unsigned int>("generated",1000);
+	unsigned int local = config.get<unsigned int>("locality",20000);
+	srand48(1);
+	// list files are any args that are not name=value pairs.
+	ricks_ga::strlist lists;
+	ricks_ga::conf_reader::iterator c = config.begin();
+	while (c != config.end())
+	{
+		if ((c->second == "") && (c->first.find("--") != 0))
+		{
+			lists.push_back(c->first);
+		};
+		c++;
+	};
+	/* 25cities.lst and 50cities.lst separate their coordinates with 
+	 * tabs, which city_list misreads (as 50 and 100 cities), so they 
+	 * are not used by default.
+	 */
+	if (lists.empty())
+	{
+		lists.push_back("10cities.lst");
+		lists.push_back("input.lst");
+	};
+	cout << setw(20) << "instance"
+		<< setw(8) << "cities"
+		<< setw(24) << "mode"
+		<< setw(14) << "evals/s"
+		<< setw(11) << "speedup"
+		<< endl;
+	for (unsigned int i=0; i < lists.size(); i++)
+	{
+		run(lists[i], lists[i], seconds);
+	};
+	if (generated > 0)
+	{
+		string name = make_instance(generated);
+		run("generated", name, seconds);
+		unlink(name.c_str());
+	};
+	if (local > 0)
+	{
+		string name = make_instance(local);
+		locality("locality", name, false, seconds);
+		unlink(name.c_str());
+		name = make_instance(std::min(local, world::table_limit));
+		locality("locality", name, true, seconds);
+		unlink(name.c_str());
+	};
+	return 0;
+};
@@ -0,0 +1,187 @@
+/***********************************************
+This file is part of the Rick's Generic GA Solver project (https://launchpad.net/ricks-ga).
+
+    Rick's Generic GA Solver is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Rick's Generic GA Solver is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Rick's Generic GA Solver.  If not, see <http://www.gnu.org/licenses/>.
+
+***********************************************/
+/* 
+	fitness memoization cache
+*/
+
+#include <algorithm>
+#include "fitness_cache.h"
+
+using namespace std;
+
+fitness_cache::fitness_cache(unsigned int capacity, unsigned int genes_per,
+	bool _tours)
+{
+	unsigned int sets = 1;
+	while (sets * ways < capacity)
+	{
+		sets <<= 1;
+	};
+	set_mask = sets - 1;
+	gene_count = genes_per;
+	unsigned int slots = sets * ways;
+	keys.assign(slots,0);
+	values.assign(slots,0);
+	referenced.assign(slots,0);
+	used.assign(slots,0);
+	hands.assign(sets,0);
+	genes.assign((size_t) slots * gene_count,0);
+	keep_tours = _tours;
+	if (keep_tours) tours.assign((size_t) slots * gene_count,0);
+	toured.assign(slots,0);
+	reset_counts();
+};
+
+unsigned long long int fitness_cache::hash(chromosome & a)
+{
+	// multiply and rotate mixing, with a final avalanche.
+	unsigned long long int h = 0x9e3779b97f4a7c15ULL ^ a.length();
+	unsigned int length = a.length();
+	const genetype * genes = a.data();
+	for (unsigned int i=0; i < length; i++)
+	{
+		h = (h ^ genes[i]) * 0xff51afd7ed558ccdULL;
+		h = (h << 29) | (h >> 35);
+	};
+	h ^= h >> 33;
+	h *= 0xc4ceb9fe1a85ec53ULL;
+	h ^= h >> 33;
+	return h;
+};
+
+bool fitness_cache::matches(unsigned int slot, chromosome & a)
+{
+	if (a.length() != gene_count) return false;
+	const genetype * g = &genes[(size_t) slot * gene_count];
+	return std::equal(a.begin(), a.end(), g);
+};
+
+bool fitness_cache::lookup(chromosome & a, unsigned long long int h)
+{
+	unsigned int set = h & set_mask;
+	stripe & s = locks[set % stripes];
+	lock_guard<mutex> guard(s.lock);
+	unsigned int first = set * ways;
+	for (unsigned int slot = first; slot < first + ways; slot++)
+	{
+		if (used[slot] && (keys[slot] == h) && matches(slot,a))
+		{
+			referenced[slot] = 1;
+			a.fitness = values[slot];
+			if (toured[slot])
+			{
+				const unsigned int * t = &tours[(size_t) slot * gene_count];
+				a.tour.assign(t, t + gene_count);
+			}
+			else
+			{
+				a.tour.clear();
+			};
+			s.hits++;
+			return true;
+		};
+	};
+	s.misses++;
+	return false;
+};
+
+void fitness_cache::store(chromosome & a, unsigned long long int h)
+{
+	if (a.length() != gene_count) return;
+	unsigned int set = h & set_mask;
+	stripe & s = locks[set % stripes];
+	lock_guard<mutex> guard(s.lock);
+	unsigned int first = set * ways;
+	// another worker may have beaten us to it.
+	for (unsigned int slot = first; slot < first + ways; slot++)
+	{
+		if (used[slot] && (keys[slot] == h) && matches(slot,a)) return;
+	};
+	// pick a victim: an empty way, or the first unreferenced one
+	// found by the clock hand.
+	unsigned int victim = first + ways;
+	for (unsigned int slot = first; slot < first + ways; slot++)
+	{
+		if (!used[slot])
+		{
+			victim = slot;
+			break;
+		};
+	};
+	while (victim == first + ways)
+	{
+		unsigned int slot = first + hands[set];
+		hands[set] = (hands[set] + 1) % ways;
+		if (referenced[slot])
+		{
+			referenced[slot] = 0;
+		}
+		else
+		{
+			victim = slot;
+		};
+	};
+	keys[victim] = h;
+	values[victim] = a.fitness;
+	referenced[victim] = 0;
+	used[victim] = 1;
+	std::copy(a.begin(), a.end(), &genes[(size_t) victim * gene_count]);
+	toured[victim] = keep_tours && (a.tour.size() == gene_count);
+	if (toured[victim])
+	{
+		std::copy(a.tour.begin(), a.tour.end(), 
+			&tours[(size_t) victim * gene_count]);
+	};
+};
+
+unsigned int fitness_cache::capacity()
+{
+	return keys.size();
+};
+
+unsigned long long int fitness_cache::hits()
+{
+	unsigned long long int returnme = 0;
+	for (unsigned int i=0; i < stripes; i++)
+	{
+		lock_guard<mutex> guard(locks[i].lock);
+		returnme += locks[i].hits;
+	};
+	return returnme;
+};
+
+unsigned long long int fitness_cache::misses()
+{
+	unsigned long long int returnme = 0;
+	for (unsigned int i=0; i < stripes; i++)
+	{
+		lock_guard<mutex> guard(locks[i].lock);
+		returnme += locks[i].misses;
+	};
+	return returnme;
+};
+
+void fitness_cache::reset_counts()
+{
+	for (unsigned int i=0; i < stripes; i++)
+	{
+		lock_guard<mutex> guard(locks[i].lock);
+		locks[i].hits = 0;
+		locks[i].misses = 0;
+	};
+};
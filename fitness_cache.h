@@ -0,0 +1,94 @@
+/***********************************************
+This file is part of the Rick's Generic GA Solver project (https://launchpad.net/ricks-ga).
+
+    Rick's Generic GA Solver is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Rick's Generic GA Solver is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Rick's Generic GA Solver.  If not, see <http://www.gnu.org/licenses/>.
+
+***********************************************/
+/* 
+	fitness memoization cache
+*/
+
+#ifndef fitness_cache_h
+#define fitness_cache_h
+
+#include <vector>
+#include <mutex>
+#include "chromosome.h"
+
+/** Bounded, thread safe cache of fitness values keyed by chromosome content.
+ ** 
+ ** Chromosomes are found by a 64 bit hash of their genes; the genes 
+ ** themselves are kept too and compared on every hit, so a hash 
+ ** collision can never return the wrong fitness.
+ ** 
+ ** The cache is 4-way set associative. Each set replaces entries with 
+ ** the CLOCK (second chance) policy: a hit sets an entry's reference 
+ ** bit, and the hand skips over (and clears) referenced entries when
+ ** looking for one to evict. Sets are guarded by a fixed number of lock
+ ** stripes, so workers rarely wait on each other. Nothing is allocated
+ ** after construction.
+ **/
+class fitness_cache
+{
+	public:
+		/** Builds a cache holding about capacity chromosomes of genes genes.
+		 ** 
+		 ** capacity is rounded up to a whole power of two number of sets.
+		 ** If tours is true each entry keeps the chromosome's tour too.
+		 **/
+		fitness_cache(unsigned int capacity, unsigned int genes, 
+			bool tours = false);
+		/// Returns the 64 bit content hash used as the key.
+		static unsigned long long int hash(chromosome & a);
+		/** Looks a up, h being hash(a).
+		 ** 
+		 ** On a hit a.fitness and a.tour (empty if no tour was kept) are
+		 ** set and true is returned.
+		 **/
+		bool lookup(chromosome & a, unsigned long long int h);
+		/// Stores a and its current fitness, h being hash(a).
+		void store(chromosome & a, unsigned long long int h);
+		/// Number of chromosomes the cache can hold.
+		unsigned int capacity();
+		/// Hits since the last reset_counts().
+		unsigned long long int hits();
+		/// Misses since the last reset_counts().
+		unsigned long long int misses();
+		void reset_counts();
+	private:
+		static const unsigned int ways = 4;
+		static const unsigned int stripes = 64;
+		unsigned int gene_count;
+		unsigned int set_mask;
+		std::vector<unsigned long long int> keys;
+		std::vector<float> values;
+		std::vector<unsigned char> referenced;
+		std::vector<unsigned char> used;
+		std::vector<unsigned char> hands;
+		std::vector<genetype> genes;
+		bool keep_tours;
+		std::vector<unsigned int> tours;
+		std::vector<unsigned char> toured;
+		struct stripe
+		{
+			std::mutex lock;
+			unsigned long long int hits;
+			unsigned long long int misses;
+		};
+		stripe locks[stripes];
+		bool matches(unsigned int slot, chromosome & a);
+		fitness_cache(const fitness_cache &);
+};
+
+#endif // fitness_cache_h
@@ -21,7 +21,11 @@ This file is part of the Rick's Generic GA Solver project (https://launchpad.net
 
 #include "fitness_tester.h"
 #include <fstream>
+#include <stdlib.h>
+#include <string.h>
 #include <math.h>
+#include <algorithm>
+#include <space_curve.h>
 
 using namespace std;
 
@@ -32,6 +36,26 @@ world::world()
 	if (!me)
 	{
 		cities.clear();
+		xs = ys = zs = 0;
+		distances = 0;
+		distances16 = 0;
+		distances32 = 0;
+		own_table = 0;
+		stride = 0;
+		quantize_bits = 0;
+		quantize_scale = 0;
+		scale = 0;
+		unit = 0;
+		near_list = 0;
+		near_count = 0;
+		curve_order = 0;
+		cache_hit = false;
+		numbering = input_numbering;
+		renumbered = false;
+		to_original = 0;
+		start = 0;
+		repairing = false;
+		use_kernel(best_kernel);
 	}
 	else
 	{
@@ -41,6 +65,7 @@ world::world()
 
 world::~world()
 {
+	free_table();
 	cities.clear();
 	me = 0;
 };
@@ -54,90 +79,732 @@ world & world::get_instance()
 	return *me;
 };
 
-void world::load(const string filename)
+void world::load(const string filename, bool use_table, 
+	unsigned int neighbors)
 {
-	// read a file and store it in cities.
-	ifstream infile(filename.c_str());
-	// set up some working storage
-	city where;
-	cities.clear();
-	// load the cities list.
-	while (infile >> where.name >> where.loc)
+	free_table();
+	saved.close();
+	cache_hit = false;
+	cities.load(filename);
+	unsigned int n = cities.size();
+	grid.build(cities.x(), cities.y(), cities.z(), n);
+	// the cities never move, so the edge costs can be done once.
+	bool table = use_table && (n <= table_limit);
+	world_cache::settings wanted;
+	wanted.cities = n;
+	wanted.neighbors = (n > 0) ? std::min(neighbors, n - 1) : 0;
+	wanted.numbering = numbering;
+	wanted.quantized = table ? quantize_bits : 0;
+	scale = wanted.quantized ? pick_scale(wanted.quantized) : 0;
+	unit = scale ? 1.0 / scale : 0;
+	wanted.scale = scale;
+	// rows are padded out to a whole number of 64 byte cache lines.
+	const unsigned int line = 64 / world_cache::entry_size(wanted);
+	wanted.stride = table ? ((n + line - 1) / line) * line : 0;
+	stride = wanted.stride;
+	string file;
+	if (!cache_dir.empty())
+	{
+		wanted.key = world_cache::key(cities);
+		file = world_cache::path(cache_dir, wanted);
+		cache_hit = saved.open(file, wanted);
+	};
+	if (cache_hit)
+	{
+		curve_order = saved.order();
+	}
+	else
+	{
+		make_curve();
+	};
+	renumber_cities();
+	if (!cache_hit)
 	{
-		cities.push_back(where);
+		derive(table, neighbors);
+		// use the file from now on so other runs can share it.
+		if (!file.empty() && world_cache::write(file, wanted, own_table, 
+			near_list, curve_order))
+		{
+			saved.open(file, wanted);
+		};
 	};
-	// close the file
-	infile.close();
+	if (saved.order())
+	{
+		free_table();
+		std::vector<unsigned int>().swap(near);
+		std::vector<unsigned int>().swap(curve);
+		set_table(saved.table());
+		near_list = saved.neighbors();
+		curve_order = saved.order();
+		near_count = wanted.neighbors;
+	};
+	stride = wanted.stride;
+	to_original = renumbered ? curve_order : 0;
+	geometry.cities = n;
+	geometry.table = distances;
+	geometry.table16 = distances16;
+	geometry.table32 = distances32;
+	geometry.unit = unit;
+	geometry.stride = stride;
+	geometry.x = xs;
+	geometry.y = ys;
+	geometry.z = zs;
 };
 
-float world::calc_distance(rank_map::iterator d, rank_map::iterator a)
+void world::make_curve()
 {
-	// calculate the xy distance
-	return d->second.loc.range(a->second.loc);
+	if (numbering == hilbert_numbering)
+	{
+		nrtb::hilbert_order(cities.x(), cities.y(), cities.z(), 
+			cities.size(), curve);
+	}
+	else
+	{
+		nrtb::morton_order(cities.x(), cities.y(), cities.z(), 
+			cities.size(), curve);
+	};
+	curve_order = curve.data();
 };
 
-float world::check_fitness(chromosome &a)
+void world::renumber_cities()
 {
-	// computes the distance traveled by the submitted chromosome.
-	// first, get a list of the cities in the desired order of travel.
-	rank_map ranked;
-	pair<int,city> new_score;
-	unsigned int length = a.length();
-	for (unsigned int i=0; i < length; i++)
+	unsigned int n = cities.size();
+	renumbered = (numbering != input_numbering) && (n > 0);
+	if (!renumbered)
+	{
+		xs = cities.x();
+		ys = cities.y();
+		zs = cities.z();
+		own_x.clear();
+		own_y.clear();
+		own_z.clear();
+		to_internal.clear();
+		to_original = 0;
+		start = 0;
+		return;
+	};
+	// internal city i is original city curve_order[i].
+	to_original = curve_order;
+	to_internal.resize(n);
+	own_x.resize(n);
+	own_y.resize(n);
+	own_z.resize(n);
+	for (unsigned int i=0; i < n; i++)
+	{
+		unsigned int o = to_original[i];
+		to_internal[o] = i;
+		own_x[i] = cities.x()[o];
+		own_y[i] = cities.y()[o];
+		own_z[i] = cities.z()[o];
+	};
+	xs = own_x.data();
+	ys = own_y.data();
+	zs = own_z.data();
+	start = to_internal[0];
+};
+
+void world::derive(bool table, unsigned int neighbors)
+{
+	if (table) build_table();
+	// neighbor lists are by original number, as the grid is.
+	near_count = grid.neighbors(neighbors, near);
+	near_list = near.data();
+};
+
+void world::renumber(numbering_type type)
+{
+	numbering = type;
+};
+
+void world::repair(bool on)
+{
+	repairing = on;
+};
+
+void world::quantize(unsigned int bits, double _scale)
+{
+	if ((bits != 0) && (bits != 16) && (bits != 32))
+	{
+		cerr << __FILE__ << "|" << __FUNCTION__ << "|" << __LINE__ 
+			<< ": tables can only be quantized to 16 or 32 bits, not " 
+			<< bits << "." << endl;
+		exit(1);
+	};
+	quantize_bits = bits;
+	quantize_scale = _scale;
+};
+
+double world::pick_scale(unsigned int bits)
+{
+	unsigned int n = cities.size();
+	// the longest edge there can be is the bounding box diagonal.
+	double diagonal = 0;
+	const float * axis[3] = {cities.x(), cities.y(), cities.z()};
+	for (int a=0; a < 3; a++)
+	{
+		if (!n) break;
+		const float * first = axis[a];
+		double span = *std::max_element(first, first + n) 
+			- *std::min_element(first, first + n);
+		diagonal += span * span;
+	};
+	diagonal = sqrt(diagonal);
+	// each entry has to fit, and so does the sum of a whole tour.
+	double largest = (bits == 16) ? 65535 : 4294967295.0;
+	largest = std::min(largest, floor(4294967295.0 / std::max(n,1u)));
+	if (quantize_scale == 0)
+	{
+		return (diagonal > 0) ? largest / diagonal : 1;
+	};
+	if (diagonal * quantize_scale > largest)
+	{
+		cerr << __FILE__ << "|" << __FUNCTION__ << "|" << __LINE__ 
+			<< ": a scale of " << quantize_scale << " overflows " << bits 
+			<< " bit table entries for these " << n << " cities; the "
+			<< "largest that fits is " << largest / diagonal << "." << endl;
+		exit(1);
+	};
+	return quantize_scale;
+};
+
+double world::quantization_error()
+{
+	if (!distances16 && !distances32) return 0;
+	return 0.5 * cities.size() / scale;
+};
+
+size_t world::table_bytes()
+{
+	if (!has_table()) return 0;
+	unsigned int entry = distances16 ? 2 : 4;
+	return (size_t) stride * cities.size() * entry;
+};
+
+void world::cache_in(const string & directory)
+{
+	cache_dir = directory;
+};
+
+bool world::used_cache()
+{
+	return cache_hit;
+};
+
+kernel_type world::use_kernel(kernel_type type)
+{
+	kernel = pick_kernel(type);
+	return type;
+};
+
+void world::build_table()
+{
+	// stride was set by load().
+	unsigned int n = cities.size();
+	unsigned int entry = quantize_bits ? quantize_bits / 8 : sizeof(float);
+	void * block = 0;
+	// a line to spare, as the 16 bit kernels read 32 bits at a time.
+	if (posix_memalign(&block, 64, (size_t) entry * stride * n + 64) != 0)
+	{
+		cerr << __FILE__ << "|" << __FUNCTION__ << "|" << __LINE__ 
+			<< ": unable to allocate a " << n << "x" << n 
+			<< " distance table." << endl;
+		exit(1);
+	};
+	own_table = block;
+	set_table(own_table);
+	memset(own_table, 0, (size_t) entry * stride * n + 64);
+	// entries are rounded, but never past the largest pick_scale allows.
+	double largest = (quantize_bits == 16) ? 65535 
+		: floor(4294967295.0 / std::max(n,1u));
+	for (unsigned int i=0; i < n; i++)
+	{
+		size_t row = (size_t) i * stride;
+		for (unsigned int j=0; j < n; j++)
+		{
+			float dx = xs[i] - xs[j];
+			float dy = ys[i] - ys[j];
+			float dz = zs[i] - zs[j];
+			float d = sqrtf(dx*dx + dy*dy + dz*dz);
+			if (distances)
+			{
+				((float *) own_table)[row + j] = d;
+				continue;
+			};
+			double q = std::min(largest, floor(d * scale + 0.5));
+			if (distances16)
+			{
+				((unsigned short *) own_table)[row + j] = q;
+			}
+			else
+			{
+				((unsigned int *) own_table)[row + j] = q;
+			};
+		};
+	};
+};
+
+void world::set_table(const void * table)
+{
+	distances = 0;
+	distances16 = 0;
+	distances32 = 0;
+	if (!table) return;
+	switch (scale ? quantize_bits : 0)
 	{
-		//ranked[a[i]] = cities[i];
-		new_score.first = a[i];
-		new_score.second = cities[i];
-		ranked.insert(new_score);
-	};	
+		case 16: distances16 = (const unsigned short *) table; break;
+		case 32: distances32 = (const unsigned int *) table; break;
+		default: distances = (const float *) table;
+	};
+};
+
+void world::free_table()
+{
+	free(own_table);
+	own_table = 0;
+	set_table(0);
+	stride = 0;
+};
+
+unsigned int world::neighbor_count()
+{
+	return near_count;
+};
+
+const nrtb::knn_grid & world::index()
+{
+	return grid;
+};
+
+bool world::has_table()
+{
+	return distances || distances16 || distances32;
+};
+
+void world::decode(chromosome & a, unsigned int * order, 
+	decode_buffer & buffer)
+{
 	// sanity check
-	if (ranked.size() != cities.size())
+	unsigned int length = a.length();
+	if (length != cities.size())
 	{
 		cerr << __FILE__ << "|" << __FUNCTION__ << "|" << __LINE__ 
-		<< ": ranked.size() [" << ranked.size()
+		<< ": a.length() [" << length
 		<< "] != cities.size() [" << cities.size()
 		<< "]\n" << "Dumping chromosome (" << a.length() << " genes):\n" 
 		<< a.enstream() 
 		<< endl;
 		exit(1); 
 	};
-	// iterate through the ranked list, calculating the travel distance.
-	rank_map::iterator departing = ranked.begin();
-	rank_map::iterator arriving = ++ranked.begin();
-	// save the starting point for the return calculation.
-	rank_map::iterator start_point = departing;
+	sort_keys(a.data(), order, buffer);
+};
+
+void world::decode(chromosome_arena::view a, unsigned int * order, 
+	decode_buffer & buffer)
+{
 	// sanity check
-	if (arriving == departing)
+	if (a.length() != cities.size())
 	{
 		cerr << __FILE__ << "|" << __FUNCTION__ << "|" << __LINE__ 
-		<< ": arriving == departing" << endl;
+		<< ": a.length() [" << a.length()
+		<< "] != cities.size() [" << cities.size() << "]" << endl;
 		exit(1); 
 	};
-	float total_dist = 0;
-	while (arriving != ranked.end())
+	sort_keys(a.data(), order, buffer);
+};
+
+void world::sort_keys(const genetype * genes, unsigned int * order,
+	decode_buffer & buffer)
+{
+	unsigned int length = cities.size();
+	// sort the city indexes by gene; the engine is picked by gene width.
+	buffer.work.resize(length);
+	ricks_ga::random_key<genetype>::decode(genes, length, order, 
+		buffer.work.data());
+	if (renumbered)
 	{
-		total_dist += calc_distance(departing,arriving);
-		arriving++;
-		departing++;
+		for (unsigned int i=0; i < length; i++)
+		{
+			order[i] = to_internal[order[i]];
+		};
+	};
+};
+
+template <class C> bool world::dead(C & a, unsigned int * order, 
+	decode_buffer & buffer)
+{
+	if (order[0] == start) return false;
+	if (!repairing) return true;
+	// the start city is original city 0, so its gene sorts first now.
+	unsigned int n = cities.size();
+	a.rotate(a[0]);
+	std::rotate(order, std::find(order, order + n, start), order + n);
+	buffer.repaired++;
+	return false;
+};
+
+float world::check_fitness(chromosome &a)
+{
+	return check_fitness(a,scratch);
+};
+
+float world::check_fitness(chromosome &a, decode_buffer & buffer, 
+	float cutoff)
+{
+	// computes the distance traveled by the submitted chromosome.
+	// first, get a list of the cities in the desired order of travel.
+	buffer.order.resize(cities.size());
+	decode(a,buffer.order.data(),buffer);
+	const unsigned int * order = buffer.order.data();
+	unsigned int length = buffer.order.size();
+	// sanity check
+	if (length < 2)
+	{
+		cerr << __FILE__ << "|" << __FUNCTION__ << "|" << __LINE__ 
+		<< ": arriving == departing" << endl;
+		exit(1); 
 	};
-	// add the return to starting point.
-	total_dist += calc_distance(departing,start_point);
 	// kill it if the first city is not the first in the list
-	if (start_point->second.name != cities[0].name)
+	float total_dist = -1;
+	a.cut_off = false;
+	if (!dead(a,buffer.order.data(),buffer))
 	{
-			total_dist = -1;
+		// the travel distance, including the return to the starting 
+		// point, added up just as the batch kernels do.
+		total_dist = 0;
+		buffer.edges_added += tour_lengths(order, 1, &total_dist, cutoff);
+		buffer.edges_needed += length;
+		a.cut_off = (cutoff > 0) && (total_dist > cutoff);
 	};
-	// store the result in the chromosome and return it.
+	// store the result in the chromosome and return it; as in the batch
+	// version no tour is kept, so update_fitness() starts afresh.
 	a.fitness = total_dist;
+	a.tour.clear();
+	a.mark_clean();
 	return total_dist;
 };
 
+void world::check_fitness(chromosome * list, unsigned int count, 
+	decode_buffer & buffer, bool keep_tours, float cutoff)
+{
+	unsigned int n = cities.size();
+	if (n < 2)
+	{
+		// let the single version report the problem.
+		check_fitness(*list,buffer);
+	};
+	buffer.tours.resize(batch_size * n);
+	buffer.lengths.resize(batch_size);
+	unsigned int * tours = buffer.tours.data();
+	float * lengths = buffer.lengths.data();
+	for (unsigned int first=0; first < count; first += batch_size)
+	{
+		unsigned int block = std::min(batch_size, count - first);
+		for (unsigned int i=0; i < block; i++)
+		{
+			decode(list[first+i], tours + i * n, buffer);
+			dead(list[first+i], tours + i * n, buffer);
+		};
+		buffer.edges_added += tour_lengths(tours, block, lengths, cutoff);
+		buffer.edges_needed += (unsigned long long int) block * n;
+		for (unsigned int i=0; i < block; i++)
+		{
+			chromosome & c = list[first+i];
+			// kill it if the first city is not the first in the list
+			bool alive = (tours[i * n] == start);
+			c.fitness = alive ? lengths[i] : -1;
+			c.cut_off = alive && (cutoff > 0) && (lengths[i] > cutoff);
+			if (keep_tours)
+			{
+				c.tour.assign(tours + i * n, tours + (i+1) * n);
+			}
+			else
+			{
+				c.tour.clear();
+			};
+			c.mark_clean();
+		};
+	};
+};
+
+const unsigned int * world::internal_tour(tour_chromosome & a, 
+	unsigned int * into)
+{
+	unsigned int n = a.length();
+	if (n != cities.size())
+	{
+		cerr << __FILE__ << "|" << __FUNCTION__ << "|" << __LINE__ 
+		<< ": a.length() [" << n
+		<< "] != cities.size() [" << cities.size() << "]" << endl;
+		exit(1); 
+	};
+	const unsigned int * tour = a.data();
+	if (!renumbered) return tour;
+	for (unsigned int i=0; i < n; i++)
+	{
+		into[i] = to_internal[tour[i]];
+	};
+	return into;
+};
+
+float world::check_fitness(tour_chromosome & a, decode_buffer & buffer, 
+	float cutoff)
+{
+	unsigned int n = cities.size();
+	if (n < 2)
+	{
+		cerr << __FILE__ << "|" << __FUNCTION__ << "|" << __LINE__ 
+		<< ": arriving == departing" << endl;
+		exit(1); 
+	};
+	buffer.order.resize(n);
+	// nothing to decode; the tour is scored where it lies.
+	const unsigned int * tour = internal_tour(a, buffer.order.data());
+	buffer.edges_added += tour_lengths(tour, 1, &a.fitness, cutoff);
+	buffer.edges_needed += n;
+	a.cut_off = (cutoff > 0) && (a.fitness > cutoff);
+	return a.fitness;
+};
+
+void world::check_fitness(tour_chromosome * list, unsigned int count, 
+	decode_buffer & buffer, float cutoff)
+{
+	unsigned int n = cities.size();
+	if (n < 2)
+	{
+		// let the single version report the problem.
+		check_fitness(*list,buffer);
+	};
+	buffer.tours.resize(batch_size * n);
+	buffer.lengths.resize(batch_size);
+	unsigned int * tours = buffer.tours.data();
+	float * lengths = buffer.lengths.data();
+	for (unsigned int first=0; first < count; first += batch_size)
+	{
+		unsigned int block = std::min(batch_size, count - first);
+		// the kernels want the block's tours back to back.
+		for (unsigned int i=0; i < block; i++)
+		{
+			unsigned int * into = tours + i * n;
+			const unsigned int * tour = internal_tour(list[first+i], into);
+			if (tour != into) std::copy(tour, tour + n, into);
+		};
+		buffer.edges_added += tour_lengths(tours, block, lengths, cutoff);
+		buffer.edges_needed += (unsigned long long int) block * n;
+		for (unsigned int i=0; i < block; i++)
+		{
+			tour_chromosome & c = list[first+i];
+			c.fitness = lengths[i];
+			c.cut_off = (cutoff > 0) && (lengths[i] > cutoff);
+		};
+	};
+};
+
+void world::check_fitness(chromosome_arena & arena, unsigned int first,
+	unsigned int count, decode_buffer & buffer, float cutoff)
+{
+	unsigned int n = cities.size();
+	if (n < 2)
+	{
+		cerr << __FILE__ << "|" << __FUNCTION__ << "|" << __LINE__ 
+		<< ": arriving == departing" << endl;
+		exit(1); 
+	};
+	buffer.tours.resize(batch_size * n);
+	buffer.lengths.resize(batch_size);
+	unsigned int * tours = buffer.tours.data();
+	float * lengths = buffer.lengths.data();
+	// the rows in the block being scored.
+	unsigned int rows[batch_size];
+	unsigned int last = first + count;
+	// a block is the changed rows of batch_size in a row.
+	for (unsigned int group = first; group < last; group += batch_size)
+	{
+		unsigned int end = std::min(last, group + batch_size);
+		unsigned int block = 0;
+		for (unsigned int r = group; r < end; r++)
+		{
+			chromosome_arena::view c = arena[r];
+			if (!c.changed()) continue;
+			decode(c, tours + block * n, buffer);
+			dead(c, tours + block * n, buffer);
+			rows[block++] = r;
+		};
+		if (!block) continue;
+		buffer.edges_added += tour_lengths(tours, block, lengths, cutoff);
+		buffer.edges_needed += (unsigned long long int) block * n;
+		for (unsigned int i=0; i < block; i++)
+		{
+			chromosome_arena::view c = arena[rows[i]];
+			// kill it if the first city is not the first in the list
+			c.fitness() = (tours[i * n] == start) ? lengths[i] : -1;
+			c.mark_clean();
+		};
+	};
+};
+
+bool world::needs_check(chromosome & a, bool keep_tours)
+{
+	switch (a.changes())
+	{
+		case chromosome::unchanged:
+			return false;
+		case chromosome::one_gene:
+			// a cut off fitness is not a length that can be adjusted.
+			return !keep_tours || (a.tour.size() != cities.size()) 
+				|| (a.fitness < 0) || a.cut_off;
+		default:
+			return true;
+	};
+};
+
+float world::update_fitness(chromosome & a, decode_buffer & buffer, 
+	bool keep_tours, float cutoff)
+{
+	if (!needs_check(a,keep_tours))
+	{
+		if ((a.changes() == chromosome::unchanged) || move_city(a,buffer))
+		{
+			a.mark_clean();
+			return a.fitness;
+		};
+	};
+	check_fitness(&a, 1, buffer, keep_tours, cutoff);
+	return a.fitness;
+};
+
+void world::update_fitness(chromosome * list, unsigned int count, 
+	decode_buffer & buffer, bool keep_tours, float cutoff)
+{
+	unsigned int i = 0;
+	while (i < count)
+	{
+		/* gather up a run of chromosomes that need the full treatment,
+		 * within one batch_size group so that the batches do not depend 
+		 * on where the list was split.
+		 */
+		unsigned int run = i;
+		while ((run < count) && needs_check(list[run],keep_tours))
+		{
+			run++;
+			if (run % batch_size == 0) break;
+		};
+		if (run > i)
+		{
+			check_fitness(list + i, run - i, buffer, keep_tours, cutoff);
+			i = run;
+		}
+		else
+		{
+			update_fitness(list[i], buffer, keep_tours, cutoff);
+			i++;
+		};
+	};
+};
+
+bool world::move_city(chromosome & a, decode_buffer & buffer)
+{
+	unsigned int n = a.tour.size();
+	if (n < 4) return false;
+	unsigned int gene = a.last_mutation_index();
+	unsigned int city = internal(gene);
+	unsigned long long int old_key = 
+		((unsigned long long int) a.replaced_gene() << 32) | gene;
+	unsigned long long int new_key = tour_key(a,city);
+	if (old_key == new_key) return true;
+	unsigned int * t = a.tour.data();
+	// find where the city was; the tour is sorted by the old keys.
+	unsigned int low = 0;
+	unsigned int high = n;
+	while (low < high)
+	{
+		unsigned int mid = (low + high) / 2;
+		unsigned long long int k = (t[mid] == city) ? old_key : tour_key(a,t[mid]);
+		if (k < old_key) { low = mid + 1; } else { high = mid; };
+	};
+	unsigned int p = low;
+	if ((p >= n) || (t[p] != city)) return false;
+	// the tour without the city: r(j) for j from 0 to n-2.
+	auto r = [&](unsigned int j) { return t[(j < p) ? j : j + 1]; };
+	// take it out, joining its neighbors.
+	unsigned int prev = t[(p + n - 1) % n];
+	unsigned int next = t[(p + 1) % n];
+	float delta = edge(prev,next) - edge(prev,city) - edge(city,next);
+	// find where it goes now in the remaining n-1 cities.
+	unsigned int m = n - 1;
+	low = 0;
+	high = m;
+	while (low < high)
+	{
+		unsigned int mid = (low + high) / 2;
+		if (tour_key(a,r(mid)) < new_key) { low = mid + 1; } else { high = mid; };
+	};
+	unsigned int q = low;
+	prev = r((q + m - 1) % m);
+	next = r(q % m);
+	delta += edge(prev,city) + edge(city,next) - edge(prev,next);
+	// only the cities between the old and new places move.
+	if (q > p)
+	{
+		std::copy(t + p + 1, t + q + 1, t + p);
+	}
+	else
+	{
+		std::copy_backward(t + q, t + p, t + p + 1);
+	};
+	t[q] = city;
+	a.fitness += delta;
+	// kill it if the first city is not the first in the list
+	if (dead(a,t,buffer))
+	{
+		a.fitness = -1;
+	};
+	return true;
+};
+
+float world::exact_length(chromosome & a)
+{
+	unsigned int n = cities.size();
+	scratch.order.resize(n);
+	decode(a,scratch.order.data(),scratch);
+	if ((n < 2) || (scratch.order[0] != start)) return -1;
+	// the coordinate path of the kernels, without the table.
+	tour_geometry direct = geometry;
+	direct.table = 0;
+	direct.table16 = 0;
+	direct.table32 = 0;
+	float returnme = 0;
+	kernel(direct, scratch.order.data(), 1, &returnme, 0);
+	return returnme;
+};
+
+float world::exact_length(tour_chromosome & a)
+{
+	unsigned int n = cities.size();
+	if (n < 2) return -1;
+	scratch.order.resize(n);
+	tour_geometry direct = geometry;
+	direct.table = 0;
+	direct.table16 = 0;
+	direct.table32 = 0;
+	float returnme = 0;
+	kernel(direct, internal_tour(a, scratch.order.data()), 1, &returnme, 0);
+	return returnme;
+};
+
+unsigned long long int world::tour_lengths(const unsigned int * tours, 
+	unsigned int count, float * lengths, float cutoff)
+{
+	return kernel(geometry, tours, count, lengths, cutoff);
+};
+
 void world::dump()
 {
 	cout << "\n===============" << endl;
 	for(unsigned int i=0; i < cities.size(); i++)
 	{
-		cout << cities[i].name << "\t" << cities[i].loc << endl;
+		cout << cities.name(i) << "\t" 
+			<< nrtb::triad<float>(cities.x()[i],cities.y()[i],cities.z()[i]) 
+			<< endl;
 	};
 	cout << "===============" << endl;
 };
@@ -149,33 +816,170 @@ int world::length()
 
 string world::show_route(chromosome &a)
 {
-	rank_map ranked;
-	pair<long long int,city> new_score;
-	for (unsigned int i=0; i < a.length(); i++)
+	scratch.order.resize(cities.size());
+	decode(a,scratch.order.data(),scratch);
+	const unsigned int * order = scratch.order.data();
+	string returnme = cities.name(original(order[0]));
+	for (unsigned int i=1; i < scratch.order.size(); i++)
 	{
-		//ranked[a[i]] = cities[i];
-		new_score.first = a[i];
-		new_score.second = cities[i];
-		ranked.insert(new_score);
-	};	
-	// sanity check
-	if (ranked.size() != cities.size())
+		returnme += "->" + cities.name(original(order[i]));
+	};
+	return returnme;
+};
+
+string world::show_route(tour_chromosome &a)
+{
+	// tour_chromosomes hold original city numbers already.
+	string returnme = cities.name(a[0]);
+	for (unsigned int i=1; i < a.length(); i++)
 	{
-		cerr << __FILE__ << "|" << __FUNCTION__ << "|" << __LINE__ 
-		<< ": ranked.size() [" << ranked.size()
-		<< "] != cities.size() [" << cities.size()
-		<< "]\n" << "Dumping chromosome (" << a.length() << " genes):\n" 
-		<< a.enstream() 
-		<< endl;
-		exit(1); 
+		returnme += "->" + cities.name(a[i]);
 	};
-	rank_map::iterator current = ranked.begin();
-	string returnme = current->second.name;
-	current++;
-	while (current != ranked.end())
+	return returnme;
+};
+
+parallel_updater::parallel_updater(nrtb::work_pool & p, bool _incremental,
+	fitness_cache * _cache):
+	pool(p)
+{
+	incremental = _incremental;
+	cache = _cache;
+	w = &(world::get_instance());
+	workers.resize(pool.size());
+	list = 0;
+	tour_list = 0;
+	arena = 0;
+	count = 0;
+	chunk = 1;
+	cutoff = 0;
+};
+
+void parallel_updater::update(vector<chromosome> & l, float _cutoff)
+{
+	list = l.empty() ? 0 : &l[0];
+	tour_list = 0;
+	arena = 0;
+	run(l.size(), _cutoff);
+};
+
+void parallel_updater::update(vector<tour_chromosome> & l, float _cutoff)
+{
+	list = 0;
+	tour_list = l.empty() ? 0 : &l[0];
+	arena = 0;
+	run(l.size(), _cutoff);
+};
+
+void parallel_updater::update(chromosome_arena & a, float _cutoff)
+{
+	list = 0;
+	tour_list = 0;
+	arena = &a;
+	run(a.size(), _cutoff);
+};
+
+void parallel_updater::run(unsigned int _count, float _cutoff)
+{
+	for (unsigned int i=0; i < workers.size(); i++)
+	{
+		workers[i].buffer.edges_added = 0;
+		workers[i].buffer.edges_needed = 0;
+		workers[i].buffer.repaired = 0;
+	};
+	if (!_count) return;
+	cutoff = _cutoff;
+	count = _count;
+	/* a few chunks per worker keeps them all busy to the end. Chunks 
+	 * are whole batches, so the kernels get full blocks.
+	 */
+	chunk = std::max(64u, count / (pool.size() * 8) + 1);
+	chunk = (chunk + world::batch_size - 1) / world::batch_size 
+		* world::batch_size;
+	/* the cache is consulted before and filled after the workers run,
+	 * in list order, so which chromosomes hit does not depend on the 
+	 * order the workers finish in.
+	 */
+	bool cached = list && cache;
+	if (cached)
+	{
+		hashes.resize(count);
+		missed.assign(count,0);
+		for (unsigned int i=0; i < count; i++)
+		{
+			chromosome & c = list[i];
+			if (!w->needs_check(c,incremental)) continue;
+			hashes[i] = fitness_cache::hash(c);
+			if (cache->lookup(c,hashes[i]))
+			{
+				c.cut_off = false;
+				c.mark_clean();
+			}
+			else
+			{
+				missed[i] = 1;
+			};
+		};
+	};
+	pool.run((count + chunk - 1) / chunk, *this);
+	if (cached)
+	{
+		for (unsigned int i=0; i < count; i++)
+		{
+			chromosome & c = list[i];
+			// only whole lengths are worth remembering.
+			if (!missed[i] || c.cut_off) continue;
+			// repaired genes start with 0 and need hashing again.
+			if (c[0] == 0) hashes[i] = fitness_cache::hash(c);
+			cache->store(c,hashes[i]);
+		};
+	};
+};
+
+void parallel_updater::operator()(unsigned int job, unsigned int worker)
+{
+	unsigned int first = job * chunk;
+	unsigned int last = std::min(count, first + chunk);
+	unsigned int size = last - first;
+	worker_state & state = workers[worker];
+	if (tour_list)
+	{
+		w->check_fitness(tour_list + first, size, state.buffer, cutoff);
+		return;
+	};
+	if (arena)
 	{
-		returnme += "->" + current->second.name;
-		current++;
+		w->check_fitness(*arena, first, size, state.buffer, cutoff);
+		return;
+	};
+	chromosome * c = list + first;
+	if (incremental || cache)
+	{
+		w->update_fitness(c, size, state.buffer, incremental, cutoff);
+	}
+	else
+	{
+		w->check_fitness(c, size, state.buffer, false, cutoff);
+	};
+};
+
+unsigned long long int parallel_updater::repaired()
+{
+	unsigned long long int returnme = 0;
+	for (unsigned int i=0; i < workers.size(); i++)
+	{
+		returnme += workers[i].buffer.repaired;
 	};
 	return returnme;
 };
+
+double parallel_updater::edges_saved()
+{
+	unsigned long long int added = 0;
+	unsigned long long int needed = 0;
+	for (unsigned int i=0; i < workers.size(); i++)
+	{
+		added += workers[i].buffer.edges_added;
+		needed += workers[i].buffer.edges_needed;
+	};
+	return needed ? 1.0 - (double) added / needed : 0;
+};
@@ -23,22 +23,144 @@ This file is part of the Rick's Generic GA Solver project (https://launchpad.net
 #define fitness_test_h
 
 #include <map>
+#include <math.h>
 #include "chromosome.h"
 #include <triad.h>
+#include <knn_grid.h>
+#include <random_key.h>
+#include <work_pool.h>
+#include "tour_kernels.h"
+#include "fitness_cache.h"
+#include "city_list.h"
+#include "world_cache.h"
+
+/** Reusable working storage for decoding a chromosome into a tour; 
+ ** each evaluator should own one.
+ **/
+struct decode_buffer
+{
+	/// city indexes in the order visited.
+	std::vector<unsigned int> order;
+	/// scratch space for the decoder.
+	std::vector<unsigned long long int> work;
+	/// a block of decoded tours for the batch kernels.
+	std::vector<unsigned int> tours;
+	/// the lengths of the tours in the block.
+	std::vector<float> lengths;
+	/// edges added up by the kernels, and the edges full checks need.
+	unsigned long long int edges_added;
+	unsigned long long int edges_needed;
+	/// chromosomes repaired instead of killed; see world::repair().
+	unsigned long long int repaired;
+	decode_buffer() { edges_added = edges_needed = repaired = 0; };
+};
 
 /* Singleton class
+ *
+ * Once load() has returned, check_fitness(a,buffer) may be called from
+ * any number of threads, each with its own decode_buffer.
  */
 class world
 {
+	public:
+		/// How cities are numbered inside the world; see renumber().
+		enum numbering_type { input_numbering = 0, morton_numbering = 1,
+			hilbert_numbering = 2 };
 	private:
-		struct city {
-			std::string name;
-			nrtb::triad<float> loc;
+		city_list cities;
+		// flat n x n table of edge lengths, rows padded to whole cache
+		// lines; NULL if not built. A quantized table (see quantize())
+		// is held in distances16 or distances32 instead, in units of unit.
+		const float * distances;
+		const unsigned short * distances16;
+		const unsigned int * distances32;
+		void * own_table;
+		unsigned int stride;
+		// requested table entry bits (0 for floats) and scale (0 for
+		// automatic), then the scale and unit in effect.
+		unsigned int quantize_bits;
+		double quantize_scale;
+		double scale;
+		double unit;
+		double pick_scale(unsigned int bits);
+		void build_table();
+		void set_table(const void * table);
+		void free_table();
+		/* city coordinates, one array per axis, in internal numbering;
+		 * to_original and to_internal convert numberings (see renumber()).
+		 */
+		const float * xs;
+		const float * ys;
+		const float * zs;
+		std::vector<float> own_x, own_y, own_z;
+		numbering_type numbering;
+		bool renumbered;
+		const unsigned int * to_original;
+		std::vector<unsigned int> to_internal;
+		// internal number of the start city.
+		unsigned int start;
+		void renumber_cities();
+		inline unsigned int internal(unsigned int city)
+		{
+			return renumbered ? to_internal[city] : city;
+		};
+		inline unsigned int original(unsigned int city)
+		{
+			return renumbered ? to_original[city] : city;
 		};
-		typedef std::vector<city> city_vector;
-		typedef std::multimap<long long int,city> rank_map;
-		city_vector cities;
-		float calc_distance(rank_map::iterator d, rank_map::iterator a);
+		// length of the edge between cities by internal number.
+		inline float edge(unsigned int from, unsigned int to)
+		{
+			if (distances) return distances[from * stride + to];
+			if (distances16) return distances16[from * stride + to] * unit;
+			if (distances32) return distances32[from * stride + to] * unit;
+			float dx = xs[from] - xs[to];
+			float dy = ys[from] - ys[to];
+			float dz = zs[from] - zs[to];
+			return sqrtf(dx*dx + dy*dy + dz*dz);
+		};
+		// sort key of city (internal number) in a's tour.
+		inline unsigned long long int tour_key(chromosome & a, 
+			unsigned int city)
+		{
+			unsigned int o = original(city);
+			return ((unsigned long long int) a.at_unchecked(o) << 32) | o;
+		};
+		// spatial index and each city's nearest neighbors.
+		nrtb::knn_grid grid;
+		std::vector<unsigned int> near;
+		const unsigned int * near_list;
+		unsigned int near_count;
+		// the cities (original numbers) in space filling curve order.
+		std::vector<unsigned int> curve;
+		const unsigned int * curve_order;
+		void make_curve();
+		// where derived data is kept between runs, if anywhere.
+		std::string cache_dir;
+		world_cache saved;
+		bool cache_hit;
+		void derive(bool table, unsigned int neighbors);
+		tour_geometry geometry;
+		tour_kernel kernel;
+		// used by the single argument check_fitness() and show_route().
+		decode_buffer scratch;
+		void decode(chromosome & a, unsigned int * order, 
+			decode_buffer & buffer);
+		void decode(chromosome_arena::view a, unsigned int * order, 
+			decode_buffer & buffer);
+		// the part of decode() common to both.
+		void sort_keys(const genetype * genes, unsigned int * order,
+			decode_buffer & buffer);
+		/* a's tour by internal number: a's own storage, or a copy 
+		 * translated into into when the cities are renumbered.
+		 */
+		const unsigned int * internal_tour(tour_chromosome & a, 
+			unsigned int * into);
+		// true if a's tour (order) does not start at the start city.
+		template <class C> bool dead(C & a, unsigned int * order, 
+			decode_buffer & buffer);
+		bool repairing;
+		bool move_city(chromosome & a, decode_buffer & buffer);
 		static world * me;
 	protected:
 		world();
@@ -46,11 +168,133 @@ class world
 		world(const world &) {};
 	public:
 		static world & get_instance();
-		void load(const std::string filename);
+		/// Largest world load() will build a distance table for.
+		static const unsigned int table_limit = 4096;
+		/** Reads the city list (text or binary, see city_list) from filename
+		 ** and builds the spatial index and neighbor lists. A distance table is
+		 ** built too if use_table is true and the world is no larger than 
+		 ** table_limit.
+		 **/
+		void load(const std::string filename, bool use_table = true,
+			unsigned int neighbors = 10);
+		/** Sets the directory load() keeps derived data in (see world_cache);
+		 ** an empty directory (the default) turns this off.
+		 **/
+		void cache_in(const std::string & directory);
+		/// True if the last load() found its derived data in the cache.
+		bool used_cache();
+		/** Sets how cities are numbered internally from the next load(). Only
+		 ** tours handed out by the world use the internal numbers.
+		 **/
+		void renumber(numbering_type type);
+		/** Sets how distance tables are stored from the next load(): bits is 0
+		 ** for floats, or 16 or 32 for unsigned integers holding the edge 
+		 ** length times scale. A scale of 0 picks the largest that fits.
+		 **/
+		void quantize(unsigned int bits, double scale = 0);
+		/** The most the fitness of a tour can differ from its length 
+		 ** because of quantization; 0 if the table is not quantized.
+		 **/
+		double quantization_error();
+		/** Turns repair of dead chromosomes on or off: with it on, a tour not
+		 ** starting at the first city is rotated to start there (see 
+		 ** basic_chromosome::rotate()) instead of being scored -1. Off by 
+		 ** default.
+		 **/
+		void repair(bool on);
+		/// Bytes taken by the distance table; 0 if there is none.
+		size_t table_bytes();
+		/** Returns the length of a's tour worked out from the city 
+		 ** coordinates; -1 if a is dead. Not thread safe.
+		 **/
+		float exact_length(chromosome & a);
+		/// exact_length() for tour_chromosomes.
+		float exact_length(tour_chromosome & a);
+		/** Returns the internal number of city; for building tours to 
+		 ** pass to tour_lengths().
+		 **/
+		inline unsigned int internal_city(unsigned int city)
+		{
+			return internal(city);
+		};
+		/// Returns the distance between cities from and to.
+		inline float distance(unsigned int from, unsigned int to)
+		{
+			return edge(internal(from), internal(to));
+		};
+		/// Returns city's neighbor_count() nearest neighbors, nearest first.
+		inline const unsigned int * nearest(unsigned int city)
+		{
+			return near_list + (size_t) city * near_count;
+		};
+		/** Returns all the cities ordered along a space filling curve, so
+		 ** cities close together in the list are close in space.
+		 **/
+		inline const unsigned int * spatial_order()
+		{
+			return curve_order;
+		};
+		/// Length of the lists returned by nearest().
+		unsigned int neighbor_count();
+		/// The spatial index built by load().
+		const nrtb::knn_grid & index();
+		/// True if the distance table was built by load().
+		bool has_table();
 		float check_fitness(chromosome &a);	
+		/** Same as check_fitness(a), but uses the caller's buffer. If cutoff
+		 ** is above 0 a tour longer than cutoff may be left partly added up,
+		 ** with a.cut_off set. a.tour is emptied and a marked clean.
+		 **/
+		float check_fitness(chromosome &a, decode_buffer & buffer, 
+			float cutoff = 0);
+		/** Batch version of check_fitness for count chromosomes starting at 
+		 ** list; a.tour is kept if keep_tours is true, emptied if not.
+		 **/
+		void check_fitness(chromosome * list, unsigned int count, 
+			decode_buffer & buffer, bool keep_tours = false, 
+			float cutoff = 0);
+		/** Batch version of check_fitness for the changed rows from first to
+		 ** first+count-1 of arena.
+		 **/
+		void check_fitness(chromosome_arena & arena, unsigned int first,
+			unsigned int count, decode_buffer & buffer, float cutoff = 0);
+		/// Scores a tour_chromosome, which is never dead.
+		float check_fitness(tour_chromosome & a, decode_buffer & buffer,
+			float cutoff = 0);
+		/// Batch version of check_fitness for tour_chromosomes.
+		void check_fitness(tour_chromosome * list, unsigned int count, 
+			decode_buffer & buffer, float cutoff = 0);
+		/** Brings the fitness of a up to date: unchanged chromosomes are left
+		 ** alone, a single mutation with a.tour held is applied to the kept 
+		 ** tour, anything else gets a full check_fitness() bounded by cutoff.
+		 ** a.tour is kept if keep_tours is true, emptied if not. Applying a
+		 ** mutation finds the city's old and new places in O(log n) but 
+		 ** moves the cities between them, so it is O(n) at worst.
+		 **/
+		float update_fitness(chromosome & a, decode_buffer & buffer,
+			bool keep_tours = true, float cutoff = 0);
+		/// True if update_fitness(a) would need a full check_fitness().
+		bool needs_check(chromosome & a, bool keep_tours = true);
+		/// Calls update_fitness on count chromosomes starting at list.
+		void update_fitness(chromosome * list, unsigned int count, 
+			decode_buffer & buffer, bool keep_tours = true, 
+			float cutoff = 0);
+		/** Writes the closed lengths of the count tours held back to back in 
+		 ** tours (internal numbers) to lengths, using the kernel picked by 
+		 ** use_kernel(). Returns the number of edges added up.
+		 **/
+		unsigned long long int tour_lengths(const unsigned int * tours, 
+			unsigned int count, float * lengths, float cutoff = 0);
+		/** Selects the kernel used by tour_lengths(), or the next best the 
+		 ** CPU supports; returns the one selected.
+		 **/
+		kernel_type use_kernel(kernel_type type);
+		/// tours decoded per call to the batch kernel.
+		static const unsigned int batch_size = 16;
 		void dump();
 		int length();
 		std::string show_route(chromosome &a);
+		std::string show_route(tour_chromosome &a);
 };
 
 class fitness_updater:
@@ -58,6 +302,7 @@ class fitness_updater:
 {
 	private: 
 		world * w;
+		decode_buffer buffer;
 	public: 
 		fitness_updater()
 		{
@@ -65,10 +310,61 @@ class fitness_updater:
 		};
 		void operator() (chromosome & c)
 		{
-			w->check_fitness(c);
+			w->check_fitness(c,buffer);
 		};
 };
 
+/// Evaluates a whole population on a work_pool.
+class parallel_updater: public nrtb::work_pool::task
+{
+	private:
+		world * w;
+		nrtb::work_pool & pool;
+		fitness_cache * cache;
+		struct worker_state
+		{
+			decode_buffer buffer;
+		};
+		std::vector<worker_state> workers;
+		// cache keys and misses of list, made before the workers start.
+		std::vector<unsigned long long int> hashes;
+		std::vector<unsigned char> missed;
+		chromosome * list;
+		tour_chromosome * tour_list;
+		chromosome_arena * arena;
+		unsigned int count;
+		unsigned int chunk;
+		bool incremental;
+		float cutoff;
+		// scores list, tour_list or arena, whichever is set, count long.
+		void run(unsigned int count, float cutoff);
+	public:
+		/** Uses world::update_fitness if incremental is true. If a cache is 
+		 ** supplied it is consulted before full checks; with incremental it 
+		 ** should keep tours.
+		 **/
+		parallel_updater(nrtb::work_pool & p, bool incremental = false,
+			fitness_cache * cache = 0);
+		/// Brings every fitness in l up to date; see world::check_fitness().
+		void update(std::vector<chromosome> & l, float cutoff = 0);
+		/** Scores every chromosome in l. tour_chromosomes are always 
+		 ** scored in full; the cache and incremental updates are not 
+		 ** used for them.
+		 **/
+		void update(std::vector<tour_chromosome> & l, float cutoff = 0);
+		/** Scores the changed rows of a (see world::check_fitness()).
+		 ** The cache and incremental updates are not used.
+		 **/
+		void update(chromosome_arena & a, float cutoff = 0);
+		/** The fraction of the edges the full checks in the last update()
+		 ** needed that were skipped because of the cutoff.
+		 **/
+		double edges_saved();
+		/// Chromosomes repaired in the last update(); see world::repair().
+		unsigned long long int repaired();
+		void operator()(unsigned int job, unsigned int worker);
+};
+
 struct dead_chromosome:
 	public std::unary_function<chromosome,bool>
 {
@@ -76,6 +372,10 @@ struct dead_chromosome:
 	{
 		return c.fitness < 0;
 	};
+	bool operator() (tour_chromosome & c)
+	{
+		return c.fitness < 0;
+	};
 };
 #endif // fitness_test_h
 
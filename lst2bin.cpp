@@ -0,0 +1,97 @@
+/***********************************************
+This file is part of the Rick's Generic GA Solver project (https://launchpad.net/ricks-ga).
+
+    Rick's Generic GA Solver is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Rick's Generic GA Solver is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Rick's Generic GA Solver.  If not, see <http://www.gnu.org/licenses/>.
+
+***********************************************/
+/*
+	city list converter.
+
+	Converts a text city list to the binary format that world::load
+	maps in place (see city_list.h), then loads the result back to 
+	check it. The time taken and resident memory of the text and binary
+	loads are reported.
+
+	usage: lst2bin input.lst output.bin
+*/
+
+// library includes.
+#include <iostream>
+#include <stdlib.h>
+#include <common.h>
+#include <hires_timer.h>
+// local includes.
+#include "city_list.h"
+
+using namespace std;
+
+int main(int argc, char* argv[])
+{
+	if (argc != 3)
+	{
+		cerr << "usage: " << argv[0] << " input.lst output.bin" << endl;
+		return 1;
+	};
+	string input = argv[1];
+	string output = argv[2];
+	unsigned long int base = nrtb::resident_kb();
+	city_list text;
+	nrtb::hirez_timer clock;
+	text.read_text(input);
+	double parsed = clock.stop();
+	unsigned long int text_kb = nrtb::resident_kb() - base;
+	if (text.size() == 0)
+	{
+		cerr << input << ": no cities found." << endl;
+		return 1;
+	};
+	clock.reset();
+	clock.start();
+	text.write(output);
+	double written = clock.stop();
+	text.clear();
+	base = nrtb::resident_kb();
+	city_list binary;
+	clock.reset();
+	clock.start();
+	binary.map(output);
+	double mapped = clock.stop();
+	unsigned long int binary_kb = nrtb::resident_kb() - base;
+	// check every city against a fresh parse of the text.
+	text.read_text(input);
+	unsigned int wrong = 0;
+	for (unsigned int i=0; i < text.size(); i++)
+	{
+		if ((text.x()[i] != binary.x()[i]) || (text.y()[i] != binary.y()[i])
+			|| (text.z()[i] != binary.z()[i]) 
+			|| (text.name(i) != binary.name(i)))
+		{
+			wrong++;
+		};
+	};
+	if ((text.size() != binary.size()) || wrong)
+	{
+		cerr << output << ": " << wrong << " cities differ from " 
+			<< input << "!" << endl;
+		return 1;
+	};
+	cout << text.size() << " cities converted.\n"
+		<< "\ttext load:   " << parsed << " seconds, " 
+		<< text_kb << "KB resident\n"
+		<< "\twrite:       " << written << " seconds\n"
+		<< "\tbinary load: " << mapped << " seconds, " 
+		<< binary_kb << "KB resident (pages are read as used)"
+		<< endl;
+	return 0;
+};
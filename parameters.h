@@ -46,6 +46,10 @@ unsigned int b_count = 500;
 // odds of any given chromosome mutating spontainiously.
 long double mutations = 1e-6;
 
+// odds of any given gene mutating spontainiously, on top of the 
+// chromosome mutations.
+long double gene_mutations = 0;
+
 // number of highest ranking chromosomes to be transfered without
 // modification to the next generation.
 unsigned int save_count = 0;
@@ -70,4 +74,15 @@ std::string infile = "input.lst";
 // which "breeding" method to use.
 bool splice = true;
 
+// number of threads used to calculate fitness.
+// 0 = one per hardware thread.
+unsigned int threads = 0;
+
+// number of chromosomes the fitness cache holds; 0 disables it.
+unsigned int cache_size = 0;
+
+// random number seed. Runs with the same seed and settings give 
+// the same results regardless of the number of threads.
+unsigned long int seed = 0;
+
 #endif // parameters_h
@@ -0,0 +1,97 @@
+/***********************************************
+This file is part of the Rick's Generic GA Solver project (https://launchpad.net/ricks-ga).
+
+    Rick's Generic GA Solver is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Rick's Generic GA Solver is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Rick's Generic GA Solver.  If not, see <http://www.gnu.org/licenses/>.
+
+***********************************************/
+/* space_curve test program */
+
+#include <stdlib.h>
+#include <math.h>
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include "space_curve.h"
+
+using namespace nrtb;
+using namespace std;
+
+// average distance between points consecutive in order.
+double step(vector<float> & x, vector<float> & y, vector<float> & z,
+	vector<unsigned int> & order)
+{
+	double total = 0;
+	for (unsigned int i=1; i < order.size(); i++)
+	{
+		float dx = x[order[i]] - x[order[i-1]];
+		float dy = y[order[i]] - y[order[i-1]];
+		float dz = z[order[i]] - z[order[i-1]];
+		total += sqrt(dx*dx + dy*dy + dz*dz);
+	};
+	return total / (order.size() - 1);
+};
+
+typedef void (*curve)(const float *, const float *, const float *,
+	unsigned int, vector<unsigned int> &);
+
+// checks one layout: the order must be a permutation, and much more local.
+int check(const string & name, curve c, vector<float> & x, 
+	vector<float> & y, vector<float> & z)
+{
+	unsigned int n = x.size();
+	vector<unsigned int> order;
+	c(&x[0], &y[0], &z[0], n, order);
+	vector<unsigned int> sorted(order);
+	sort(sorted.begin(), sorted.end());
+	int errors = 0;
+	for (unsigned int i=0; i < n; i++)
+	{
+		if (sorted[i] != i) errors++;
+	};
+	vector<unsigned int> given(n);
+	for (unsigned int i=0; i < n; i++)
+	{
+		given[i] = i;
+	};
+	double before = step(x,y,z,given);
+	double after = step(x,y,z,order);
+	if (after * 4 > before) errors++;
+	cout << name << ": average step " << before << " in input order, "
+		<< after << " in curve order; " << errors << " errors." << endl;
+	return errors;
+};
+
+int main()
+{
+	int errors = 0;
+	srand48(1);
+	unsigned int n = 20000;
+	vector<float> x(n), y(n), z(n);
+	for (unsigned int i=0; i < n; i++)
+	{
+		x[i] = drand48() * 1000;
+		y[i] = drand48() * 1000;
+		z[i] = drand48() * 1000;
+	};
+	errors += check("morton cube", morton_order, x, y, z);
+	errors += check("hilbert cube", hilbert_order, x, y, z);
+	for (unsigned int i=0; i < n; i++)
+	{
+		z[i] = 0;
+	};
+	errors += check("morton plane", morton_order, x, y, z);
+	errors += check("hilbert plane", hilbert_order, x, y, z);
+	cout << "space_curve test " << (errors ? "FAILED" : "passed") << endl;
+	return errors;
+};
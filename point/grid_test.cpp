@@ -0,0 +1,127 @@
+/***********************************************
+This file is part of the Rick's Generic GA Solver project (https://launchpad.net/ricks-ga).
+
+    Rick's Generic GA Solver is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Rick's Generic GA Solver is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Rick's Generic GA Solver.  If not, see <http://www.gnu.org/licenses/>.
+
+***********************************************/
+/* knn_grid test program */
+
+#include <stdlib.h>
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include "knn_grid.h"
+#include "hires_timer.h"
+
+using namespace nrtb;
+using namespace std;
+
+// brute force k nearest neighbors of point i, ordered as knn_grid does.
+vector<unsigned int> brute(vector<float> & x, vector<float> & y, 
+	vector<float> & z, unsigned int i, unsigned int k)
+{
+	vector< pair<float,unsigned int> > all;
+	for (unsigned int j=0; j < x.size(); j++)
+	{
+		if (j == i) continue;
+		float dx = x[j] - x[i];
+		float dy = y[j] - y[i];
+		float dz = z[j] - z[i];
+		all.push_back(make_pair(dx*dx + dy*dy + dz*dz, j));
+	};
+	sort(all.begin(), all.end());
+	vector<unsigned int> returnme;
+	for (unsigned int j=0; (j < k) && (j < all.size()); j++)
+	{
+		returnme.push_back(all[j].second);
+	};
+	return returnme;
+};
+
+// checks every point of one layout against brute force.
+int check(const string & name, vector<float> & x, vector<float> & y,
+	vector<float> & z, unsigned int k)
+{
+	knn_grid grid;
+	grid.build(&x[0], &y[0], &z[0], x.size());
+	vector<unsigned int> lists;
+	unsigned int per = grid.neighbors(k, lists);
+	int errors = 0;
+	for (unsigned int i=0; i < x.size(); i++)
+	{
+		vector<unsigned int> expected = brute(x,y,z,i,k);
+		if ((expected.size() != per) 
+			|| !equal(expected.begin(), expected.end(), lists.begin() + i * per))
+		{
+			errors++;
+		};
+	};
+	cout << name << ": " << x.size() << " points, k=" << k << ", "
+		<< errors << " wrong lists." << endl;
+	return errors;
+};
+
+int main()
+{
+	int errors = 0;
+	srand48(1);
+	unsigned int n = 2000;
+	vector<float> x(n), y(n), z(n);
+	// evenly spread in 3 dimensions.
+	for (unsigned int i=0; i < n; i++)
+	{
+		x[i] = drand48() * 1000;
+		y[i] = drand48() * 1000;
+		z[i] = drand48() * 1000;
+	};
+	errors += check("cube", x, y, z, 8);
+	// flat, on a coarse lattice so there are ties and duplicates.
+	for (unsigned int i=0; i < n; i++)
+	{
+		x[i] = lrand48() % 40;
+		y[i] = lrand48() % 40;
+		z[i] = 0;
+	};
+	errors += check("lattice", x, y, z, 8);
+	// tight clusters far apart.
+	for (unsigned int i=0; i < n; i++)
+	{
+		float cx = (i % 4) * 10000;
+		x[i] = cx + drand48();
+		y[i] = drand48();
+		z[i] = cx - drand48();
+	};
+	errors += check("clusters", x, y, z, 8);
+	// fewer points than k.
+	x.resize(5); y.resize(5); z.resize(5);
+	errors += check("tiny", x, y, z, 8);
+	// timing on a large instance.
+	n = 100000;
+	x.resize(n); y.resize(n); z.resize(n);
+	for (unsigned int i=0; i < n; i++)
+	{
+		x[i] = drand48() * 1000;
+		y[i] = drand48() * 1000;
+		z[i] = drand48() * 1000;
+	};
+	hirez_timer t;
+	knn_grid grid;
+	grid.build(&x[0], &y[0], &z[0], n);
+	vector<unsigned int> lists;
+	grid.neighbors(10, lists);
+	cout << n << " points, 10 neighbors each: " << t.stop() 
+		<< " seconds." << endl;
+	cout << "knn_grid test " << (errors ? "FAILED" : "passed") << endl;
+	return errors;
+};
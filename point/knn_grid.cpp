@@ -0,0 +1,223 @@
+/***********************************************
+This file is part of the Rick's Generic GA Solver project (https://launchpad.net/ricks-ga).
+
+    Rick's Generic GA Solver is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Rick's Generic GA Solver is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Rick's Generic GA Solver.  If not, see <http://www.gnu.org/licenses/>.
+
+***********************************************/
+/* knn_grid.cpp - uniform grid spatial index implementation.
+*/
+
+#include <math.h>
+#include <algorithm>
+#include "knn_grid.h"
+
+using namespace std;
+
+namespace nrtb
+{
+
+namespace
+{
+	// a candidate neighbor; the heap keeps the worst one on top.
+	struct candidate
+	{
+		float d2;
+		unsigned int index;
+		bool operator < (const candidate & a) const
+		{
+			return (d2 < a.d2) || ((d2 == a.d2) && (index < a.index));
+		};
+	};
+};
+
+knn_grid::knn_grid()
+{
+	px = py = pz = 0;
+	count = 0;
+	scale = side = 0;
+	for (int a=0; a < 3; a++)
+	{
+		low[a] = 0;
+		dims[a] = 1;
+	};
+};
+
+int knn_grid::cell_of(float v, int axis) const
+{
+	int returnme = (int) ((v - low[axis]) * scale);
+	return std::max(0, std::min(dims[axis] - 1, returnme));
+};
+
+void knn_grid::build(const float * x, const float * y, const float * z,
+	unsigned int n)
+{
+	px = x;
+	py = y;
+	pz = z;
+	count = n;
+	const float * axis[3] = {x, y, z};
+	float extent[3];
+	double volume = 1;
+	int flat = 0;
+	for (int a=0; a < 3; a++)
+	{
+		float lo = 0;
+		float hi = 0;
+		if (n > 0)
+		{
+			lo = *min_element(axis[a], axis[a] + n);
+			hi = *max_element(axis[a], axis[a] + n);
+		};
+		low[a] = lo;
+		extent[a] = hi - lo;
+		if (extent[a] > 0) { volume *= extent[a]; } else { flat++; };
+	};
+	// cubic cells holding about four points each.
+	int used = 3 - flat;
+	side = 0;
+	if (used > 0)
+	{
+		side = pow(volume / std::max(1.0, n / 4.0), 1.0 / used);
+	};
+	scale = (side > 0) ? 1.0 / side : 0;
+	unsigned int cells = 1;
+	for (int a=0; a < 3; a++)
+	{
+		dims[a] = 1;
+		if ((extent[a] > 0) && (side > 0))
+		{
+			dims[a] = std::max(1, std::min(1 << 20, 
+				(int) ceil(extent[a] / side)));
+		};
+		cells *= dims[a];
+	};
+	// counting sort of the points by cell.
+	first.assign(cells + 1, 0);
+	members.resize(n);
+	vector<unsigned int> home(n);
+	for (unsigned int i=0; i < n; i++)
+	{
+		home[i] = (cell_of(z[i],2) * dims[1] + cell_of(y[i],1)) * dims[0]
+			+ cell_of(x[i],0);
+		first[home[i] + 1]++;
+	};
+	for (unsigned int c=0; c < cells; c++)
+	{
+		first[c + 1] += first[c];
+	};
+	vector<unsigned int> fill(first.begin(), first.end() - 1);
+	for (unsigned int i=0; i < n; i++)
+	{
+		members[fill[home[i]]++] = i;
+	};
+};
+
+unsigned int knn_grid::size() const
+{
+	return count;
+};
+
+unsigned int knn_grid::nearest(unsigned int i, unsigned int k, 
+	unsigned int * out) const
+{
+	if ((i >= count) || (k == 0)) return 0;
+	k = std::min(k, count - 1);
+	float x = px[i];
+	float y = py[i];
+	float z = pz[i];
+	int c[3] = {cell_of(x,0), cell_of(y,1), cell_of(z,2)};
+	int reach = std::max(dims[0], std::max(dims[1], dims[2]));
+	vector<candidate> heap;
+	heap.reserve(k + 1);
+	// offers every point in cell to the heap of the k best so far.
+	auto scan = [&](int cx, int cy, int cz)
+	{
+		unsigned int cell = (cz * dims[1] + cy) * dims[0] + cx;
+		for (unsigned int m = first[cell]; m < first[cell + 1]; m++)
+		{
+			unsigned int j = members[m];
+			if (j == i) continue;
+			float dx = px[j] - x;
+			float dy = py[j] - y;
+			float dz = pz[j] - z;
+			candidate n = {dx*dx + dy*dy + dz*dz, j};
+			if (heap.size() < k)
+			{
+				heap.push_back(n);
+				push_heap(heap.begin(), heap.end());
+			}
+			else if (n < heap.front())
+			{
+				pop_heap(heap.begin(), heap.end());
+				heap.back() = n;
+				push_heap(heap.begin(), heap.end());
+			};
+		};
+	};
+	for (int r=0; r <= reach; r++)
+	{
+		// visit the cells exactly r cells away from ours.
+		int z0 = std::max(0, c[2] - r);
+		int z1 = std::min(dims[2] - 1, c[2] + r);
+		int y0 = std::max(0, c[1] - r);
+		int y1 = std::min(dims[1] - 1, c[1] + r);
+		for (int cz = z0; cz <= z1; cz++)
+		{
+			for (int cy = y0; cy <= y1; cy++)
+			{
+				if ((abs(cz - c[2]) == r) || (abs(cy - c[1]) == r))
+				{
+					int x0 = std::max(0, c[0] - r);
+					int x1 = std::min(dims[0] - 1, c[0] + r);
+					for (int cx = x0; cx <= x1; cx++)
+					{
+						scan(cx, cy, cz);
+					};
+				}
+				else
+				{
+					// inside the shell only the two x ends are new.
+					if (c[0] - r >= 0) scan(c[0] - r, cy, cz);
+					if (c[0] + r < dims[0]) scan(c[0] + r, cy, cz);
+				};
+			};
+		};
+		// anything not yet seen is at least r cells away.
+		if (heap.size() == k)
+		{
+			float bound = r * side;
+			if (heap.front().d2 <= bound * bound) break;
+		};
+	};
+	sort_heap(heap.begin(), heap.end());
+	for (unsigned int h=0; h < heap.size(); h++)
+	{
+		out[h] = heap[h].index;
+	};
+	return heap.size();
+};
+
+unsigned int knn_grid::neighbors(unsigned int k, 
+	vector<unsigned int> & lists) const
+{
+	unsigned int per = (count > 0) ? std::min(k, count - 1) : 0;
+	lists.resize((size_t) count * per);
+	for (unsigned int i=0; i < count; i++)
+	{
+		nearest(i, per, &lists[(size_t) i * per]);
+	};
+	return per;
+};
+
+} // namespace nrtb
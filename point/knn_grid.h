@@ -0,0 +1,88 @@
+/***********************************************
+This file is part of the Rick's Generic GA Solver project (https://launchpad.net/ricks-ga).
+
+    Rick's Generic GA Solver is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Rick's Generic GA Solver is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Rick's Generic GA Solver.  If not, see <http://www.gnu.org/licenses/>.
+
+***********************************************/
+/* knn_grid.h - uniform grid spatial index for nearest neighbor queries.
+*/
+
+#ifndef knn_grid_h
+#define knn_grid_h
+
+#include <vector>
+
+namespace nrtb
+{
+
+/** Uniform grid over a fixed set of points, used to find each point's 
+ ** nearest neighbors.
+ ** 
+ ** The bounding box of the points is cut into cubic cells sized to hold 
+ ** about four points each, with flat axes (all points at the same 
+ ** coordinate) getting a single cell. The points are bucketed by cell 
+ ** with a counting sort, so the grid takes O(n) memory and building it 
+ ** is O(n). A query searches rings of cells outward from the query 
+ ** point's cell until no unsearched cell can hold anything closer than
+ ** what has been found. For points that are spread out reasonably 
+ ** evenly this is O(k) work per query.
+ ** 
+ ** The coordinates are held as pointers and must outlive the grid, or
+ ** at least the queries made against it.
+ **/
+class knn_grid
+{
+	public:
+		knn_grid();
+		/** Indexes the n points whose coordinates are x[i], y[i], z[i].
+		 ** 
+		 ** Replaces any previous contents.
+		 **/
+		void build(const float * x, const float * y, const float * z,
+			unsigned int n);
+		/// Number of points indexed.
+		unsigned int size() const;
+		/** Finds the k points closest to point i, not counting i itself.
+		 ** 
+		 ** Their indexes are written to out, nearest first; equally 
+		 ** distant points are ordered by index. Returns the number found,
+		 ** which is k unless the grid holds no more than k points.
+		 **/
+		unsigned int nearest(unsigned int i, unsigned int k, 
+			unsigned int * out) const;
+		/** Fills lists with the min(k,size()-1) nearest neighbors of 
+		 ** every point, point i's starting at lists[i * that]. 
+		 ** 
+		 ** Returns the number of neighbors listed per point.
+		 **/
+		unsigned int neighbors(unsigned int k, 
+			std::vector<unsigned int> & lists) const;
+	private:
+		const float * px;
+		const float * py;
+		const float * pz;
+		unsigned int count;
+		float low[3];
+		float scale;
+		float side;
+		int dims[3];
+		// members of cell c are members[first[c]] to members[first[c+1]-1].
+		std::vector<unsigned int> first;
+		std::vector<unsigned int> members;
+		int cell_of(float v, int axis) const;
+};
+
+} // namespace nrtb
+
+#endif // knn_grid_h
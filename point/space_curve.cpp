@@ -0,0 +1,164 @@
+/***********************************************
+This file is part of the Rick's Generic GA Solver project (https://launchpad.net/ricks-ga).
+
+    Rick's Generic GA Solver is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Rick's Generic GA Solver is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Rick's Generic GA Solver.  If not, see <http://www.gnu.org/licenses/>.
+
+***********************************************/
+/* space_curve.cpp - space filling curve orderings.
+*/
+
+#include <algorithm>
+#include "space_curve.h"
+
+using namespace std;
+
+namespace nrtb
+{
+
+namespace
+{
+	const unsigned int bits = 21;
+	const unsigned int cells = 1u << bits;
+
+	// spreads the low 21 bits of v out to every third bit.
+	unsigned long long int spread(unsigned long long int v)
+	{
+		v &= 0x1fffff;
+		v = (v | (v << 32)) & 0x1f00000000ffffULL;
+		v = (v | (v << 16)) & 0x1f0000ff0000ffULL;
+		v = (v | (v << 8)) & 0x100f00f00f00f00fULL;
+		v = (v | (v << 4)) & 0x10c30c30c30c30c3ULL;
+		v = (v | (v << 2)) & 0x1249249249249249ULL;
+		return v;
+	};
+
+	// scales each value of one axis to [0,cells); false if it is flat.
+	bool quantize(const float * v, unsigned int n, 
+		vector<unsigned int> & out)
+	{
+		out.assign(n,0);
+		if (n == 0) return false;
+		float lo = *min_element(v, v + n);
+		float hi = *max_element(v, v + n);
+		if (!(hi > lo)) return false;
+		double scale = (cells - 1) / ((double) hi - lo);
+		for (unsigned int i=0; i < n; i++)
+		{
+			out[i] = (unsigned int) ((v[i] - (double) lo) * scale);
+		};
+		return true;
+	};
+
+	// sorts the indexes by key, ties staying in index order.
+	void by_key(vector< pair<unsigned long long int, unsigned int> > & keyed,
+		vector<unsigned int> & order)
+	{
+		sort(keyed.begin(), keyed.end());
+		order.resize(keyed.size());
+		for (unsigned int i=0; i < keyed.size(); i++)
+		{
+			order[i] = keyed[i].second;
+		};
+	};
+
+	/* position along the Hilbert curve of the point at the dims 
+	 * coordinates in p, each of bits bits. This is Skilling's method 
+	 * ("Programming the Hilbert curve", 2004): transform the coordinates
+	 * in place, then interleave their bits.
+	 */
+	unsigned long long int hilbert(unsigned int * p, int dims, int bits)
+	{
+		unsigned int m = 1u << (bits - 1);
+		for (unsigned int q = m; q > 1; q >>= 1)
+		{
+			unsigned int mask = q - 1;
+			for (int i=0; i < dims; i++)
+			{
+				if (p[i] & q)
+				{
+					p[0] ^= mask;
+				}
+				else
+				{
+					unsigned int t = (p[0] ^ p[i]) & mask;
+					p[0] ^= t;
+					p[i] ^= t;
+				};
+			};
+		};
+		// gray encode.
+		for (int i=1; i < dims; i++)
+		{
+			p[i] ^= p[i-1];
+		};
+		unsigned int t = 0;
+		for (unsigned int q = m; q > 1; q >>= 1)
+		{
+			if (p[dims-1] & q) t ^= q - 1;
+		};
+		unsigned long long int returnme = 0;
+		for (int b = bits - 1; b >= 0; b--)
+		{
+			for (int i=0; i < dims; i++)
+			{
+				returnme = (returnme << 1) | (((p[i] ^ t) >> b) & 1);
+			};
+		};
+		return returnme;
+	};
+};
+
+void morton_order(const float * x, const float * y, const float * z,
+	unsigned int n, vector<unsigned int> & order)
+{
+	vector<unsigned int> qx, qy, qz;
+	quantize(x, n, qx);
+	quantize(y, n, qy);
+	quantize(z, n, qz);
+	vector< pair<unsigned long long int, unsigned int> > keyed(n);
+	for (unsigned int i=0; i < n; i++)
+	{
+		keyed[i].first = spread(qx[i]) | (spread(qy[i]) << 1) 
+			| (spread(qz[i]) << 2);
+		keyed[i].second = i;
+	};
+	by_key(keyed, order);
+};
+
+void hilbert_order(const float * x, const float * y, const float * z,
+	unsigned int n, vector<unsigned int> & order)
+{
+	vector<unsigned int> q[3];
+	vector<unsigned int> * used[3];
+	int dims = 0;
+	const float * axis[3] = {x, y, z};
+	for (int a=0; a < 3; a++)
+	{
+		if (quantize(axis[a], n, q[a])) used[dims++] = &q[a];
+	};
+	vector< pair<unsigned long long int, unsigned int> > keyed(n);
+	for (unsigned int i=0; i < n; i++)
+	{
+		unsigned int p[3] = {0, 0, 0};
+		for (int d=0; d < dims; d++)
+		{
+			p[d] = (*used[d])[i];
+		};
+		keyed[i].first = dims ? hilbert(p, dims, bits) : 0;
+		keyed[i].second = i;
+	};
+	by_key(keyed, order);
+};
+
+} // namespace nrtb
@@ -0,0 +1,52 @@
+/***********************************************
+This file is part of the Rick's Generic GA Solver project (https://launchpad.net/ricks-ga).
+
+    Rick's Generic GA Solver is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Rick's Generic GA Solver is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Rick's Generic GA Solver.  If not, see <http://www.gnu.org/licenses/>.
+
+***********************************************/
+/* space_curve.h - orders points along a space filling curve.
+*/
+
+#ifndef space_curve_h
+#define space_curve_h
+
+#include <vector>
+
+namespace nrtb
+{
+
+/** Fills order with the indexes of the n points x[i], y[i], z[i] sorted 
+ ** along a Morton (Z order) curve through their bounding box.
+ ** 
+ ** Each axis is scaled to 21 bits and the bits are interleaved, so points
+ ** close together along the curve are close together in space. Axes on 
+ ** which all the points agree are ignored. Points with the same curve 
+ ** position keep their original relative order.
+ **/
+void morton_order(const float * x, const float * y, const float * z,
+	unsigned int n, std::vector<unsigned int> & order);
+
+/** Same as morton_order(), but along a Hilbert curve.
+ ** 
+ ** The Hilbert curve never jumps: points next to each other along it 
+ ** are in neighboring cells, which the Morton curve only manages most of 
+ ** the time. It works in as many dimensions as there are axes on which 
+ ** the points differ, so a flat instance gets the 2D curve.
+ **/
+void hilbert_order(const float * x, const float * y, const float * z,
+	unsigned int n, std::vector<unsigned int> & order);
+
+} // namespace nrtb
+
+#endif // space_curve_h
@@ -0,0 +1,80 @@
+/***********************************************
+This file is part of the Rick's Generic GA Solver project (https://launchpad.net/ricks-ga).
+
+    Rick's Generic GA Solver is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Rick's Generic GA Solver is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Rick's Generic GA Solver.  If not, see <http://www.gnu.org/licenses/>.
+
+***********************************************/
+
+/* work_pool test program */
+
+#include <iostream>
+#include <vector>
+#include "work_pool.h"
+#include "hires_timer.h"
+
+using namespace nrtb;
+using namespace std;
+
+// fills each job's slot with a value that depends only on the job.
+class filler: public work_pool::task
+{
+	public:
+		vector<unsigned long long> slots;
+		vector<unsigned int> by_worker;
+		void operator()(unsigned int job, unsigned int worker)
+		{
+			unsigned long long v = job;
+			for (int i=0; i < 10000; i++)
+			{
+				v = v * 6364136223846793005ULL + 1442695040888963407ULL;
+			};
+			slots[job] = v;
+			by_worker[worker]++;
+		};
+};
+
+int main()
+{
+	int errors = 0;
+	vector<unsigned long long> reference;
+	unsigned int sizes[] = {1, 2, 4, 0};
+	for (int s=0; s < 4; s++)
+	{
+		work_pool pool(sizes[s]);
+		filler f;
+		f.slots.assign(5000,0);
+		f.by_worker.assign(pool.size(),0);
+		hirez_timer t;
+		// several rounds to exercise reuse of the threads.
+		for (int round=0; round < 5; round++)
+		{
+			pool.run(f.slots.size(),f);
+		};
+		double elapsed = t.stop();
+		if (reference.empty()) reference = f.slots;
+		if (f.slots != reference)
+		{
+			cout << "Results differ with " << pool.size() << " workers!" << endl;
+			errors++;
+		};
+		cout << pool.size() << " workers: " << elapsed << " seconds; jobs per worker:";
+		for (unsigned int i=0; i < f.by_worker.size(); i++)
+		{
+			cout << " " << f.by_worker[i];
+		};
+		cout << endl;
+	};
+	cout << "work_pool test " << (errors ? "FAILED" : "passed") << endl;
+	return errors;
+};
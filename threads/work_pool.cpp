@@ -0,0 +1,128 @@
+/***********************************************
+This file is part of the Rick's Generic GA Solver project (https://launchpad.net/ricks-ga).
+
+    Rick's Generic GA Solver is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Rick's Generic GA Solver is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Rick's Generic GA Solver.  If not, see <http://www.gnu.org/licenses/>.
+
+***********************************************/
+
+// see work_pool.h for documentation
+
+#include "work_pool.h"
+
+namespace nrtb
+{
+
+work_pool::work_pool(unsigned int size)
+{
+	if (size == 0)
+	{
+		size = std::thread::hardware_concurrency();
+	};
+	if (size == 0)
+	{
+		size = 1;
+	};
+	current = 0;
+	job_count = 0;
+	next_job = 0;
+	busy = 0;
+	round = 0;
+	quit = false;
+	for (unsigned int i=1; i < size; i++)
+	{
+		threads.push_back(std::thread(&work_pool::worker, this, i));
+	};
+};
+
+work_pool::~work_pool()
+{
+	{
+		std::unique_lock<std::mutex> guard(lock);
+		quit = true;
+	};
+	wake.notify_all();
+	for (unsigned int i=0; i < threads.size(); i++)
+	{
+		threads[i].join();
+	};
+};
+
+unsigned int work_pool::size()
+{
+	return threads.size() + 1;
+};
+
+void work_pool::run(unsigned int jobs, task & t)
+{
+	if (threads.empty())
+	{
+		for (unsigned int i=0; i < jobs; i++)
+		{
+			t(i,0);
+		};
+		return;
+	};
+	{
+		std::unique_lock<std::mutex> guard(lock);
+		current = &t;
+		job_count = jobs;
+		next_job = 0;
+		busy = threads.size();
+		round++;
+	};
+	wake.notify_all();
+	work(0);
+	// wait for the other workers to finish their last jobs.
+	std::unique_lock<std::mutex> guard(lock);
+	while (busy > 0)
+	{
+		done.wait(guard);
+	};
+	current = 0;
+};
+
+void work_pool::worker(unsigned int id)
+{
+	unsigned long long int seen = 0;
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> guard(lock);
+			while (!quit && (round == seen))
+			{
+				wake.wait(guard);
+			};
+			if (quit) return;
+			seen = round;
+		};
+		work(id);
+		std::unique_lock<std::mutex> guard(lock);
+		if (--busy == 0)
+		{
+			done.notify_one();
+		};
+	};
+};
+
+void work_pool::work(unsigned int id)
+{
+	unsigned int job = next_job++;
+	while (job < job_count)
+	{
+		(*current)(job,id);
+		job = next_job++;
+	};
+};
+
+} // namespace nrtb
@@ -0,0 +1,83 @@
+/***********************************************
+This file is part of the Rick's Generic GA Solver project (https://launchpad.net/ricks-ga).
+
+    Rick's Generic GA Solver is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Rick's Generic GA Solver is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Rick's Generic GA Solver.  If not, see <http://www.gnu.org/licenses/>.
+
+***********************************************/
+
+#ifndef nrtb_work_pool_h
+#define nrtb_work_pool_h
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+namespace nrtb
+{
+
+/** A fixed set of worker threads that share out numbered jobs.
+ ** 
+ ** Usage: derive a class from work_pool::task and implement 
+ ** operator()(job,worker), then hand an instance to run() along with
+ ** the number of jobs. run() returns once every job in 0..jobs-1 has 
+ ** been done exactly once. The calling thread works too, as worker 0,
+ ** so a pool of size 1 starts no threads at all.
+ ** 
+ ** Which worker does which job is not defined; tasks that need 
+ ** repeatable results should make each job's output depend only on 
+ ** the job number, and may use the worker number (always less than 
+ ** size()) to pick private working storage.
+ **/
+class work_pool
+{
+	public:
+		/// Interface for the work handed to run().
+		class task
+		{
+			public:
+				virtual ~task() {};
+				virtual void operator()(unsigned int job, unsigned int worker) = 0;
+		};
+		/** Starts threads-1 worker threads. 
+		 ** 
+		 ** If threads is 0 one worker per hardware thread is used.
+		 **/
+		work_pool(unsigned int threads = 0);
+		/// Stops and joins all the worker threads.
+		~work_pool();
+		/// Number of workers, including the calling thread.
+		unsigned int size();
+		/// Runs job 0 through jobs-1 of t and waits for all of them.
+		void run(unsigned int jobs, task & t);
+	private:
+		std::vector<std::thread> threads;
+		std::mutex lock;
+		std::condition_variable wake;
+		std::condition_variable done;
+		task * current;
+		unsigned int job_count;
+		std::atomic<unsigned int> next_job;
+		unsigned int busy;
+		unsigned long long int round;
+		bool quit;
+		void worker(unsigned int id);
+		void work(unsigned int id);
+		work_pool(const work_pool &);
+};
+
+} // namespace nrtb
+
+#endif // nrtb_work_pool_h
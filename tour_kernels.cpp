@@ -0,0 +1,534 @@
+/***********************************************
+This file is part of the Rick's Generic GA Solver project (https://launchpad.net/ricks-ga).
+
+    Rick's Generic GA Solver is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Rick's Generic GA Solver is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Rick's Generic GA Solver.  If not, see <http://www.gnu.org/licenses/>.
+
+***********************************************/
+/* 
+	batched tour length kernels
+
+	The vector kernels run 8 (AVX2) or 16 (AVX-512) tours at once, one 
+	per lane, gathering city indexes and edge costs. The lanes add their
+	edges up in tour order and stop past the cutoff at the same edge as 
+	the scalar code does; this file is built without floating point 
+	contraction so no multiply-add is fused and all kernels give bit for
+	bit the same lengths.
+*/
+
+#include "tour_kernels.h"
+#include <math.h>
+#include <algorithm>
+#include <immintrin.h>
+
+// edge length worked out from the coordinates, the same way triad::range does.
+static inline float edge(const tour_geometry & g, unsigned int from, 
+	unsigned int to)
+{
+	if (g.table) return g.table[from * g.stride + to];
+	float dx = g.x[from] - g.x[to];
+	float dy = g.y[from] - g.y[to];
+	float dz = g.z[from] - g.z[to];
+	return sqrtf(dx*dx + dy*dy + dz*dz);
+};
+
+// entry of the quantized table for the edge.
+static inline unsigned int quantized_edge(const tour_geometry & g, 
+	unsigned int from, unsigned int to)
+{
+	size_t cell = (size_t) from * g.stride + to;
+	return g.table16 ? g.table16[cell] : g.table32[cell];
+};
+
+// adds the edge from -> to on to total.
+static inline void add_edge(const tour_geometry & g, unsigned int from, 
+	unsigned int to, float & total)
+{
+	total += edge(g, from, to);
+};
+
+// the same for quantized totals.
+static inline void add_edge(const tour_geometry & g, unsigned int from, 
+	unsigned int to, unsigned int & total)
+{
+	total += quantized_edge(g, from, to);
+};
+
+static inline float length_of(const tour_geometry & /*g*/, float total)
+{
+	return total;
+};
+
+static inline float length_of(const tour_geometry & g, unsigned int total)
+{
+	return total * g.unit;
+};
+
+/* the largest quantized total whose length is not over cutoff, so a
+ * total past it always gives a length past cutoff.
+ */
+static unsigned int quantized_limit(const tour_geometry & g, float cutoff)
+{
+	double q = floor(cutoff / g.unit);
+	if (q >= 4294967295.0) return 0xffffffff;
+	unsigned int returnme = q;
+	// rounding to float may put the length either side of cutoff.
+	while ((returnme > 0) && ((float) (returnme * g.unit) > cutoff))
+	{
+		returnme--;
+	};
+	while ((returnme < 0xffffffff) 
+		&& ((float) ((returnme + 1.0) * g.unit) <= cutoff))
+	{
+		returnme++;
+	};
+	return returnme;
+};
+
+/* adds tour up into total, stopping at the first edge that takes it 
+ * past limit; returns the number of edges added.
+ */
+template <class S> static unsigned int add_tour(const tour_geometry & g, 
+	const unsigned int * tour, S & total, S limit)
+{
+	unsigned int n = g.cities;
+	unsigned int i = 1;
+	total = 0;
+	while ((i < n) && (total <= limit))
+	{
+		add_edge(g, tour[i-1], tour[i], total);
+		i++;
+	};
+	if (i < n) return i - 1;
+	add_edge(g, tour[n-1], tour[0], total);
+	return n;
+};
+
+static unsigned long long int scalar_lengths(const tour_geometry & g, 
+	const unsigned int * tours, unsigned int count, float * lengths,
+	float cutoff)
+{
+	unsigned int n = g.cities;
+	unsigned long long int returnme = 0;
+	if (g.table16 || g.table32)
+	{
+		unsigned int limit = (cutoff > 0) ? quantized_limit(g, cutoff) 
+			: 0xffffffff;
+		for (unsigned int t=0; t < count; t++)
+		{
+			unsigned int total;
+			returnme += add_tour(g, tours + t * n, total, limit);
+			lengths[t] = length_of(g, total);
+		};
+		return returnme;
+	};
+	float ceiling = (cutoff > 0) ? cutoff : INFINITY;
+	for (unsigned int t=0; t < count; t++)
+	{
+		float total;
+		returnme += add_tour(g, tours + t * n, total, ceiling);
+		lengths[t] = total;
+	};
+	return returnme;
+};
+
+/* The vector kernels give each of their W lanes a tour of its own. A 
+ * lane that has added up its tour, or gone past the cutoff, hands in 
+ * its length and starts on the next tour, so no lane waits on another.
+ * Lane l is at edge prev -> tours[at] of tour job with left edges to 
+ * go before the one closing the tour, and is running if bit l of mask
+ * is set (active[l] is then -1, for the AVX2 masked gathers). Between
+ * hand ins the lanes take as many steps as the shortest() has left, 
+ * checking the cutoff, if there is one, after each.
+ */
+template <unsigned int W, class S> struct lane_state
+{
+	int at[W];
+	int prev[W];
+	int left[W];
+	int active[W];
+	S total[W];
+	unsigned int job[W];
+	unsigned int mask;
+	const unsigned int * tours;
+	unsigned int n;
+	unsigned int count;
+	unsigned int next;
+	lane_state(const unsigned int * _tours, unsigned int _n, 
+		unsigned int _count)
+	{
+		tours = _tours;
+		n = _n;
+		count = _count;
+		next = 0;
+		mask = 0;
+		for (unsigned int l=0; l < W; l++)
+		{
+			at[l] = 0;
+			prev[l] = 0;
+			start(l);
+		};
+	};
+	// starts lane l on the next tour, or stops it if there are none.
+	void start(unsigned int l)
+	{
+		total[l] = 0;
+		if (next == count)
+		{
+			// a stopped lane reads nothing and never finishes.
+			left[l] = 0x7fffffff;
+			active[l] = 0;
+			mask &= ~(1u << l);
+			return;
+		};
+		job[l] = next;
+		at[l] = next * n + 1;
+		prev[l] = tours[next * n];
+		left[l] = n - 1;
+		active[l] = -1;
+		mask |= 1u << l;
+		next++;
+	};
+	/* writes the length of lane l's tour, which the kernel has closed 
+	 * if left is 0; returns the number of edges added up.
+	 */
+	unsigned int hand_in(const tour_geometry & g, float * lengths, 
+		unsigned int l)
+	{
+		lengths[job[l]] = length_of(g, total[l]);
+		return left[l] ? n - 1 - left[l] : n;
+	};
+	// edges until the first running lane is ready to close its tour.
+	unsigned int shortest()
+	{
+		unsigned int returnme = 0x7fffffff;
+		for (unsigned int l=0; l < W; l++)
+		{
+			if (!(mask & (1u << l))) continue;
+			returnme = std::min(returnme, (unsigned int) left[l]);
+		};
+		return returnme;
+	};
+	// hands in and restarts the lanes set in done.
+	unsigned long long int retire(const tour_geometry & g, float * lengths,
+		unsigned int done)
+	{
+		unsigned long long int returnme = 0;
+		for (unsigned int l=0; l < W; l++)
+		{
+			if (!(done & (1u << l))) continue;
+			returnme += hand_in(g, lengths, l);
+			start(l);
+		};
+		return returnme;
+	};
+};
+
+__attribute__((target("avx2")))
+static inline __m256 edges_avx2(const tour_geometry & g, __m256i from, 
+	__m256i to)
+{
+	if (g.table)
+	{
+		__m256i cell = _mm256_add_epi32(
+			_mm256_mullo_epi32(from, _mm256_set1_epi32(g.stride)), to);
+		return _mm256_i32gather_ps(g.table, cell, 4);
+	};
+	__m256 dx = _mm256_sub_ps(_mm256_i32gather_ps(g.x, from, 4),
+		_mm256_i32gather_ps(g.x, to, 4));
+	__m256 dy = _mm256_sub_ps(_mm256_i32gather_ps(g.y, from, 4),
+		_mm256_i32gather_ps(g.y, to, 4));
+	__m256 dz = _mm256_sub_ps(_mm256_i32gather_ps(g.z, from, 4),
+		_mm256_i32gather_ps(g.z, to, 4));
+	__m256 sum = _mm256_add_ps(
+		_mm256_add_ps(_mm256_mul_ps(dx,dx), _mm256_mul_ps(dy,dy)),
+		_mm256_mul_ps(dz,dz));
+	return _mm256_sqrt_ps(sum);
+};
+
+__attribute__((target("avx2")))
+static inline __m256i quantized_avx2(const tour_geometry & g, 
+	__m256i from, __m256i to)
+{
+	__m256i cell = _mm256_add_epi32(
+		_mm256_mullo_epi32(from, _mm256_set1_epi32(g.stride)), to);
+	if (g.table32) return _mm256_i32gather_epi32((const int *) g.table32, cell, 4);
+	// 16 bit entries are read as the low half of a 32 bit load.
+	return _mm256_and_si256(
+		_mm256_i32gather_epi32((const int *) g.table16, cell, 2),
+		_mm256_set1_epi32(0xffff));
+};
+
+__attribute__((target("avx2")))
+static unsigned long long int avx2_lengths(const tour_geometry & g, 
+	const unsigned int * tours, unsigned int count, float * lengths,
+	float cutoff)
+{
+	unsigned int n = g.cities;
+	if (n < 2) return scalar_lengths(g, tours, count, lengths, cutoff);
+	unsigned long long int returnme = 0;
+	const int * base = (const int *) tours;
+	__m256i one = _mm256_set1_epi32(1);
+	__m256i zero = _mm256_setzero_si256();
+	__m256i size = _mm256_set1_epi32(n);
+	if (g.table16 || g.table32)
+	{
+		unsigned int limit = (cutoff > 0) ? quantized_limit(g, cutoff) 
+			: 0xffffffff;
+		__m256i over = _mm256_set1_epi32(limit);
+		bool bounded = (limit < 0xffffffff);
+		lane_state<8, unsigned int> s(tours, n, count);
+		while (s.mask)
+		{
+			__m256i at = _mm256_loadu_si256((__m256i *) s.at);
+			__m256i prev = _mm256_loadu_si256((__m256i *) s.prev);
+			__m256i left = _mm256_loadu_si256((__m256i *) s.left);
+			__m256i active = _mm256_loadu_si256((__m256i *) s.active);
+			__m256i total = _mm256_loadu_si256((__m256i *) s.total);
+			unsigned int done = 0;
+			for (unsigned int k = s.shortest(); k && !done; k--)
+			{
+				__m256i next = _mm256_mask_i32gather_epi32(prev, base, at, 
+					active, 4);
+				total = _mm256_add_epi32(total, quantized_avx2(g, prev, next));
+				prev = next;
+				at = _mm256_add_epi32(at, one);
+				if (!bounded) continue;
+				// past limit: max(total, limit) is not limit.
+				done = ~_mm256_movemask_ps(_mm256_castsi256_ps(
+					_mm256_cmpeq_epi32(_mm256_max_epu32(total, over), over)));
+				done &= s.mask;
+			};
+			left = _mm256_sub_epi32(left, _mm256_sub_epi32(at, 
+				_mm256_loadu_si256((__m256i *) s.at)));
+			__m256i closing = _mm256_and_si256(active, 
+				_mm256_cmpeq_epi32(left, zero));
+			if (!_mm256_testz_si256(closing, closing))
+			{
+				// the last city of a closing tour is at - 1, its first at - n.
+				__m256i first = _mm256_mask_i32gather_epi32(prev, base,
+					_mm256_sub_epi32(at, size), closing, 4);
+				total = _mm256_add_epi32(total, _mm256_and_si256(closing,
+					quantized_avx2(g, prev, first)));
+				done |= _mm256_movemask_ps(_mm256_castsi256_ps(closing));
+			};
+			_mm256_storeu_si256((__m256i *) s.at, at);
+			_mm256_storeu_si256((__m256i *) s.prev, prev);
+			_mm256_storeu_si256((__m256i *) s.left, left);
+			_mm256_storeu_si256((__m256i *) s.total, total);
+			returnme += s.retire(g, lengths, done);
+		};
+		return returnme;
+	};
+	bool bounded = (cutoff > 0);
+	__m256 ceiling = _mm256_set1_ps(cutoff);
+	lane_state<8, float> s(tours, n, count);
+	while (s.mask)
+	{
+		__m256i at = _mm256_loadu_si256((__m256i *) s.at);
+		__m256i prev = _mm256_loadu_si256((__m256i *) s.prev);
+		__m256i left = _mm256_loadu_si256((__m256i *) s.left);
+		__m256i active = _mm256_loadu_si256((__m256i *) s.active);
+		__m256 total = _mm256_loadu_ps(s.total);
+		unsigned int done = 0;
+		for (unsigned int k = s.shortest(); k && !done; k--)
+		{
+			__m256i next = _mm256_mask_i32gather_epi32(prev, base, at, 
+				active, 4);
+			total = _mm256_add_ps(total, edges_avx2(g, prev, next));
+			prev = next;
+			at = _mm256_add_epi32(at, one);
+			if (!bounded) continue;
+			done = _mm256_movemask_ps(
+				_mm256_cmp_ps(total, ceiling, _CMP_GT_OQ)) & s.mask;
+		};
+		left = _mm256_sub_epi32(left, _mm256_sub_epi32(at, 
+			_mm256_loadu_si256((__m256i *) s.at)));
+		__m256i closing = _mm256_and_si256(active, 
+			_mm256_cmpeq_epi32(left, zero));
+		if (!_mm256_testz_si256(closing, closing))
+		{
+			__m256i first = _mm256_mask_i32gather_epi32(prev, base,
+				_mm256_sub_epi32(at, size), closing, 4);
+			total = _mm256_add_ps(total, _mm256_and_ps(
+				_mm256_castsi256_ps(closing), edges_avx2(g, prev, first)));
+			done |= _mm256_movemask_ps(_mm256_castsi256_ps(closing));
+		};
+		_mm256_storeu_si256((__m256i *) s.at, at);
+		_mm256_storeu_si256((__m256i *) s.prev, prev);
+		_mm256_storeu_si256((__m256i *) s.left, left);
+		_mm256_storeu_ps(s.total, total);
+		returnme += s.retire(g, lengths, done);
+	};
+	return returnme;
+};
+
+__attribute__((target("avx512f")))
+static inline __m512 edges_avx512(const tour_geometry & g, __m512i from, 
+	__m512i to)
+{
+	if (g.table)
+	{
+		__m512i cell = _mm512_add_epi32(
+			_mm512_mullo_epi32(from, _mm512_set1_epi32(g.stride)), to);
+		return _mm512_i32gather_ps(cell, g.table, 4);
+	};
+	__m512 dx = _mm512_sub_ps(_mm512_i32gather_ps(from, g.x, 4),
+		_mm512_i32gather_ps(to, g.x, 4));
+	__m512 dy = _mm512_sub_ps(_mm512_i32gather_ps(from, g.y, 4),
+		_mm512_i32gather_ps(to, g.y, 4));
+	__m512 dz = _mm512_sub_ps(_mm512_i32gather_ps(from, g.z, 4),
+		_mm512_i32gather_ps(to, g.z, 4));
+	__m512 sum = _mm512_add_ps(
+		_mm512_add_ps(_mm512_mul_ps(dx,dx), _mm512_mul_ps(dy,dy)),
+		_mm512_mul_ps(dz,dz));
+	return _mm512_sqrt_ps(sum);
+};
+
+__attribute__((target("avx512f")))
+static inline __m512i quantized_avx512(const tour_geometry & g, 
+	__m512i from, __m512i to)
+{
+	__m512i cell = _mm512_add_epi32(
+		_mm512_mullo_epi32(from, _mm512_set1_epi32(g.stride)), to);
+	if (g.table32) return _mm512_i32gather_epi32(cell, g.table32, 4);
+	// 16 bit entries are read as the low half of a 32 bit load.
+	return _mm512_and_si512(_mm512_i32gather_epi32(cell, g.table16, 2),
+		_mm512_set1_epi32(0xffff));
+};
+
+__attribute__((target("avx512f")))
+static unsigned long long int avx512_lengths(const tour_geometry & g, 
+	const unsigned int * tours, unsigned int count, float * lengths,
+	float cutoff)
+{
+	unsigned int n = g.cities;
+	if (n < 2) return scalar_lengths(g, tours, count, lengths, cutoff);
+	unsigned long long int returnme = 0;
+	const int * base = (const int *) tours;
+	__m512i one = _mm512_set1_epi32(1);
+	__m512i zero = _mm512_setzero_si512();
+	__m512i size = _mm512_set1_epi32(n);
+	if (g.table16 || g.table32)
+	{
+		unsigned int limit = (cutoff > 0) ? quantized_limit(g, cutoff) 
+			: 0xffffffff;
+		__m512i over = _mm512_set1_epi32(limit);
+		bool bounded = (limit < 0xffffffff);
+		lane_state<16, unsigned int> s(tours, n, count);
+		while (s.mask)
+		{
+			__m512i at = _mm512_loadu_si512(s.at);
+			__m512i prev = _mm512_loadu_si512(s.prev);
+			__m512i left = _mm512_loadu_si512(s.left);
+			__m512i total = _mm512_loadu_si512(s.total);
+			__mmask16 active = s.mask;
+			unsigned int done = 0;
+			for (unsigned int k = s.shortest(); k && !done; k--)
+			{
+				__m512i next = _mm512_mask_i32gather_epi32(prev, active, at, 
+					base, 4);
+				total = _mm512_add_epi32(total, quantized_avx512(g, prev, next));
+				prev = next;
+				at = _mm512_add_epi32(at, one);
+				if (!bounded) continue;
+				done = _mm512_cmpgt_epu32_mask(total, over) & s.mask;
+			};
+			left = _mm512_sub_epi32(left, _mm512_sub_epi32(at, 
+				_mm512_loadu_si512(s.at)));
+			__mmask16 closing = _mm512_cmpeq_epi32_mask(left, zero) & s.mask;
+			if (closing)
+			{
+				// the last city of a closing tour is at - 1, its first at - n.
+				__m512i first = _mm512_mask_i32gather_epi32(prev, closing, 
+					_mm512_sub_epi32(at, size), base, 4);
+				total = _mm512_mask_add_epi32(total, closing, total, 
+					quantized_avx512(g, prev, first));
+				done |= closing;
+			};
+			_mm512_storeu_si512(s.at, at);
+			_mm512_storeu_si512(s.prev, prev);
+			_mm512_storeu_si512(s.left, left);
+			_mm512_storeu_si512(s.total, total);
+			returnme += s.retire(g, lengths, done);
+		};
+		return returnme;
+	};
+	bool bounded = (cutoff > 0);
+	__m512 ceiling = _mm512_set1_ps(cutoff);
+	lane_state<16, float> s(tours, n, count);
+	while (s.mask)
+	{
+		__m512i at = _mm512_loadu_si512(s.at);
+		__m512i prev = _mm512_loadu_si512(s.prev);
+		__m512i left = _mm512_loadu_si512(s.left);
+		__m512 total = _mm512_loadu_ps(s.total);
+		__mmask16 active = s.mask;
+		unsigned int done = 0;
+		for (unsigned int k = s.shortest(); k && !done; k--)
+		{
+			__m512i next = _mm512_mask_i32gather_epi32(prev, active, at, 
+				base, 4);
+			total = _mm512_add_ps(total, edges_avx512(g, prev, next));
+			prev = next;
+			at = _mm512_add_epi32(at, one);
+			if (!bounded) continue;
+			done = _mm512_cmp_ps_mask(total, ceiling, _CMP_GT_OQ) & s.mask;
+		};
+		left = _mm512_sub_epi32(left, _mm512_sub_epi32(at, 
+			_mm512_loadu_si512(s.at)));
+		__mmask16 closing = _mm512_cmpeq_epi32_mask(left, zero) & s.mask;
+		if (closing)
+		{
+			__m512i first = _mm512_mask_i32gather_epi32(prev, closing, 
+				_mm512_sub_epi32(at, size), base, 4);
+			total = _mm512_mask_add_ps(total, closing, total, 
+				edges_avx512(g, prev, first));
+			done |= closing;
+		};
+		_mm512_storeu_si512(s.at, at);
+		_mm512_storeu_si512(s.prev, prev);
+		_mm512_storeu_si512(s.left, left);
+		_mm512_storeu_ps(s.total, total);
+		returnme += s.retire(g, lengths, done);
+	};
+	return returnme;
+};
+
+tour_kernel pick_kernel(kernel_type & type)
+{
+	__builtin_cpu_init();
+	if ((type <= avx512_kernel) && __builtin_cpu_supports("avx512f"))
+	{
+		type = avx512_kernel;
+		return avx512_lengths;
+	};
+	if ((type <= avx2_kernel) && __builtin_cpu_supports("avx2"))
+	{
+		type = avx2_kernel;
+		return avx2_lengths;
+	};
+	type = scalar_kernel;
+	return scalar_lengths;
+};
+
+const char * kernel_name(kernel_type type)
+{
+	switch (type)
+	{
+		case avx512_kernel: return "avx512";
+		case avx2_kernel: return "avx2";
+		case scalar_kernel: return "scalar";
+		default: return "best";
+	};
+};
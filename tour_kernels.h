@@ -0,0 +1,79 @@
+/***********************************************
+This file is part of the Rick's Generic GA Solver project (https://launchpad.net/ricks-ga).
+
+    Rick's Generic GA Solver is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Rick's Generic GA Solver is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Rick's Generic GA Solver.  If not, see <http://www.gnu.org/licenses/>.
+
+***********************************************/
+/* 
+	batched tour length kernels
+*/
+
+#ifndef tour_kernels_h
+#define tour_kernels_h
+
+/** Everything a kernel needs to know about the cities.
+ ** 
+ ** table is the flat distance table (row i starts at table + i*stride),
+ ** or NULL in which case edge lengths are worked out from the x, y and
+ ** z coordinate arrays. Quantized tables are summed as integers and the
+ ** total scaled once, so they too give the same length in every kernel.
+ **/
+struct tour_geometry
+{
+	unsigned int cities;
+	const float * table;
+	/* quantized distance tables, laid out like table; at most one of 
+	 * table, table16 and table32 is set. An edge is its entry times 
+	 * unit. The entries of one tour must add up to less than 2^32.
+	 */
+	const unsigned short * table16;
+	const unsigned int * table32;
+	double unit;
+	unsigned int stride;
+	const float * x;
+	const float * y;
+	const float * z;
+};
+
+/** Signature shared by all the kernels.
+ ** 
+ ** tours holds count tours back to back, each g.cities city indexes 
+ ** long. The closed length of tour t (including the edge back to its 
+ ** first city) is written to lengths[t]. Every kernel adds the edges up
+ ** in the same order as world::check_fitness does, so all of them give
+ ** the same answers.
+ ** 
+ ** If cutoff is above 0 a kernel stops adding up a tour at the first 
+ ** edge that takes it past cutoff, leaving that partial length; the 
+ ** same in every kernel. Lengths not over cutoff are always complete.
+ ** Returns the number of edges added up.
+ **/
+typedef unsigned long long int (*tour_kernel)(const tour_geometry & g, 
+	const unsigned int * tours, unsigned int count, float * lengths,
+	float cutoff);
+
+/// The kernels available, in order of preference.
+enum kernel_type { best_kernel, avx512_kernel, avx2_kernel, scalar_kernel };
+
+/** Returns the requested kernel, or the next best one the CPU supports.
+ ** 
+ ** The CPU is checked at run time; best_kernel picks the widest one 
+ ** available. type is updated to say which was actually picked.
+ **/
+tour_kernel pick_kernel(kernel_type & type);
+
+/// Human readable kernel name.
+const char * kernel_name(kernel_type type);
+
+#endif // tour_kernels_h
@@ -0,0 +1,185 @@
+/***********************************************
+This file is part of the Rick's Generic GA Solver project (https://launchpad.net/ricks-ga).
+
+    Rick's Generic GA Solver is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Rick's Generic GA Solver is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Rick's Generic GA Solver.  If not, see <http://www.gnu.org/licenses/>.
+
+***********************************************/
+/*
+	parallel fitness update test.
+
+	Runs the same generations of copies and mutations through a 
+	parallel_updater with a fitness_cache on 1 and on several threads,
+	with and without incremental updates, and checks that every 
+	chromosome gets the same fitness and every generation the same 
+	cache hits either way. Also checks that a chromosome scored by the
+	single check_fitness() is not updated again by update_fitness().
+
+	usage: update_test [threads=n]
+*/
+
+// library includes.
+#include <vector>
+#include <fstream>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <confreader.h>
+// local includes.
+#include "chromosome.h"
+#include "fitness_tester.h"
+#include "fitness_cache.h"
+
+using namespace std;
+
+const unsigned int population = 2000;
+const unsigned int generations = 40;
+
+// the fitness of every chromosome and the hits of every generation.
+struct run_record
+{
+	vector<float> fitness;
+	vector<unsigned long long int> hits;
+};
+
+run_record run(unsigned int threads, bool incremental, unsigned int genes)
+{
+	run_record returnme;
+	nrtb::work_pool pool(threads);
+	// small, so entries are evicted as well as found.
+	fitness_cache cache(256, genes, incremental);
+	parallel_updater update(pool, incremental, &cache);
+	ricks_ga::xoshiro256ss rng(11);
+	vector<chromosome> list(population);
+	for (unsigned int i=0; i < population; i++)
+	{
+		list[i].reload(genes, rng);
+	};
+	for (unsigned int g=0; g < generations; g++)
+	{
+		cache.reset_counts();
+		update.update(list);
+		for (unsigned int i=0; i < population; i++)
+		{
+			returnme.fitness.push_back(list[i].fitness);
+		};
+		returnme.hits.push_back(cache.hits());
+		// copies of a few parents (mostly hits), some mutated.
+		for (unsigned int i=0; i < population; i++)
+		{
+			switch (rng() % 4)
+			{
+				case 0: 
+					break;
+				case 1:
+					list[i].mutate(rng);
+					break;
+				case 2:
+				case 3:
+				{
+					chromosome & parent = list[rng() % 50];
+					if (&parent == &list[i]) break;
+					list[i].load(parent.data(), genes);
+					if (rng() % 2) list[i].mutate(rng);
+					break;
+				};
+			};
+		};
+	};
+	return returnme;
+};
+
+// number of places a and b differ, bit for bit.
+unsigned int differences(run_record & a, run_record & b)
+{
+	unsigned int returnme = 0;
+	for (unsigned int i=0; i < a.fitness.size(); i++)
+	{
+		if (memcmp(&a.fitness[i], &b.fitness[i], sizeof(float))) returnme++;
+	};
+	for (unsigned int i=0; i < a.hits.size(); i++)
+	{
+		if (a.hits[i] != b.hits[i]) returnme++;
+	};
+	return returnme;
+};
+
+/* chromosomes mutated once, scored by the single check_fitness() and
+ * then updated; returns the number update_fitness() changed.
+ */
+unsigned int single_check_errors(world & w, unsigned int genes)
+{
+	unsigned int returnme = 0;
+	decode_buffer buffer;
+	ricks_ga::xoshiro256ss rng(13);
+	// every chromosome lives, so each has a tour to keep.
+	w.repair(true);
+	for (unsigned int i=0; i < 200; i++)
+	{
+		chromosome c;
+		c.reload(genes, rng);
+		w.update_fitness(c, buffer);
+		c.mutate(rng);
+		float expected = w.check_fitness(c, buffer);
+		w.update_fitness(c, buffer);
+		if (memcmp(&expected, &c.fitness, sizeof(float))) returnme++;
+	};
+	w.repair(false);
+	return returnme;
+};
+
+int main(int argc, char* argv[])
+{
+	ricks_ga::conf_reader config;
+	config.read(argc,argv,"");
+	unsigned int threads = config.get<unsigned int>("threads",4);
+	// a random world of 100 cities.
+	char name[] = "/tmp/update_test_XXXXXX";
+	int fd = mkstemp(name);
+	if (fd < 0)
+	{
+		cerr << "unable to create a temporary city list." << endl;
+		return 1;
+	};
+	close(fd);
+	ofstream out(name);
+	ricks_ga::xoshiro256ss places(5);
+	for (unsigned int i=0; i < 100; i++)
+	{
+		out << "c" << i << "\t" << (int) (places() % 1000) - 500 << ","
+			<< (int) (places() % 1000) - 500 << ",0" << endl;
+	};
+	out.close();
+	world & w = world::get_instance();
+	w.load(name);
+	unlink(name);
+	int errors = 0;
+	for (int incremental=0; incremental < 2; incremental++)
+	{
+		run_record one = run(1, incremental, w.length());
+		run_record many = run(threads, incremental, w.length());
+		unsigned int wrong = differences(one, many);
+		unsigned long long int hits = 0;
+		for (unsigned int i=0; i < one.hits.size(); i++) hits += one.hits[i];
+		cout << (incremental ? "incremental" : "full") << ": 1 and " 
+			<< threads << " threads, " << hits << " cache hits, " 
+			<< wrong << " differences" << endl;
+		if (wrong || !hits) errors++;
+	};
+	unsigned int stale = single_check_errors(w, w.length());
+	cout << "single check then update: " << stale << " changed" << endl;
+	if (stale) errors++;
+	cout << "parallel update check: " 
+		<< (errors ? "FAILED" : "passed") << endl;
+	return errors;
+};
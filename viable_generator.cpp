@@ -0,0 +1,117 @@
+/***********************************************
+This file is part of the Rick's Generic GA Solver project (https://launchpad.net/ricks-ga).
+
+    Rick's Generic GA Solver is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Rick's Generic GA Solver is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Rick's Generic GA Solver.  If not, see <http://www.gnu.org/licenses/>.
+
+***********************************************/
+/* 
+	viable chromosome generator
+*/
+
+#include <math.h>
+#include <algorithm>
+#include "viable_generator.h"
+
+using namespace std;
+
+namespace
+{
+	// number of distinct gene values.
+	const double keys = pow(2.0, 8.0 * sizeof(genetype));
+	const unsigned long long int max_key = (unsigned long long int) keys - 1;
+};
+
+viable_generator::viable_generator(unsigned int _genes)
+{
+	genes = _genes;
+	if ((sizeof(genetype) <= 2) && (genes > 1))
+	{
+		/* gene 0 holds k when the other genes-1 are all k or more, 
+		 * so P(k) is proportional to ((keys-k)/keys)^(genes-1).
+		 */
+		cdf.resize(keys);
+		double total = 0;
+		for (unsigned int k=0; k < cdf.size(); k++)
+		{
+			total += exp((genes - 1) * log1p(-(k / keys)));
+			cdf[k] = total;
+		};
+		for (unsigned int k=0; k < cdf.size(); k++)
+		{
+			cdf[k] /= total;
+		};
+	};
+};
+
+unsigned long long int viable_generator::smallest(
+	ricks_ga::xoshiro256ss & rng)
+{
+	double u = (rng() >> 11) * (1.0 / 9007199254740992.0);
+	unsigned long long int returnme;
+	if (!cdf.empty())
+	{
+		returnme = upper_bound(cdf.begin(), cdf.end(), u) - cdf.begin();
+	}
+	else
+	{
+		// the smallest of genes uniform values on [0,1).
+		returnme = (unsigned long long int) 
+			floor(keys * (1.0 - pow(1.0 - u, 1.0 / genes)));
+	};
+	return std::min(returnme, max_key);
+};
+
+void viable_generator::build(chromosome & a, ricks_ga::xoshiro256ss & rng,
+	vector<genetype> & scratch)
+{
+	scratch.resize(genes);
+	if (genes == 0)
+	{
+		a.load(0,0);
+		return;
+	};
+	unsigned long long int low = smallest(rng);
+	unsigned long long int range = max_key - low + 1;
+	scratch[0] = low;
+	for (unsigned int i=1; i < genes; i++)
+	{
+		scratch[i] = low + (((rng() >> 32) * range) >> 32);
+	};
+	a.load(&scratch[0], genes);
+	a.fitness = 0;
+	a.tour.clear();
+};
+
+void viable_generator::fill(vector<chromosome> & l, unsigned int c,
+	unsigned long long int s, nrtb::work_pool & pool)
+{
+	l.resize(c);
+	if (c == 0) return;
+	list = &l[0];
+	count = c;
+	seed = s;
+	scratch.resize(pool.size());
+	pool.run((count + chunk - 1) / chunk, *this);
+};
+
+void viable_generator::operator()(unsigned int job, unsigned int worker)
+{
+	// each chunk has its own stream, so workers can't change the results.
+	ricks_ga::xoshiro256ss rng(seed, job);
+	unsigned int last = std::min(count, (job + 1) * chunk);
+	for (unsigned int i = job * chunk; i < last; i++)
+	{
+		build(list[i], rng, scratch[worker]);
+	};
+};
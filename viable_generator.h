@@ -0,0 +1,73 @@
+/***********************************************
+This file is part of the Rick's Generic GA Solver project (https://launchpad.net/ricks-ga).
+
+    Rick's Generic GA Solver is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Rick's Generic GA Solver is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Rick's Generic GA Solver.  If not, see <http://www.gnu.org/licenses/>.
+
+***********************************************/
+/* 
+	viable chromosome generator
+*/
+
+#ifndef viable_generator_h
+#define viable_generator_h
+
+#include <vector>
+#include <work_pool.h>
+#include "chromosome.h"
+
+/** Builds random chromosomes the world will accept as viable.
+ ** 
+ ** A chromosome is viable when its start city (gene 0) holds the 
+ ** smallest key; ties go to gene 0. Rather than building chromosomes 
+ ** and throwing away the dead ones, which for large worlds is nearly 
+ ** all of them, gene 0 is drawn from the distribution of the smallest 
+ ** of length() uniform keys and the rest are drawn uniformly from 
+ ** gene 0's value up. The result has the same distribution as random 
+ ** chromosomes that passed the viability test.
+ ** 
+ ** For genes of up to 16 bits the distribution of gene 0 is tabled 
+ ** exactly; wider genes use the continuous approximation.
+ **/
+class viable_generator: public nrtb::work_pool::task
+{
+	public:
+		/// Prepares to build chromosomes of genes genes.
+		viable_generator(unsigned int genes);
+		/** Loads a with a viable set of genes.
+		 ** 
+		 ** The genes are drawn from rng; scratch is working storage.
+		 **/
+		void build(chromosome & a, ricks_ga::xoshiro256ss & rng,
+			std::vector<genetype> & scratch);
+		/** Replaces the contents of list with count viable chromosomes.
+		 ** 
+		 ** The work is spread over pool. The chromosomes built depend on 
+		 ** seed alone, not on the number of workers.
+		 **/
+		void fill(std::vector<chromosome> & list, unsigned int count,
+			unsigned long long int seed, nrtb::work_pool & pool);
+		/// Work pool entry point used by fill().
+		void operator()(unsigned int job, unsigned int worker);
+	private:
+		static const unsigned int chunk = 256;
+		unsigned int genes;
+		std::vector<double> cdf;
+		std::vector< std::vector<genetype> > scratch;
+		chromosome * list;
+		unsigned int count;
+		unsigned long long int seed;
+		unsigned long long int smallest(ricks_ga::xoshiro256ss & rng);
+};
+
+#endif // viable_generator_h
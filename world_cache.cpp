@@ -0,0 +1,217 @@
+/***********************************************
+This file is part of the Rick's Generic GA Solver project (https://launchpad.net/ricks-ga).
+
+    Rick's Generic GA Solver is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Rick's Generic GA Solver is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Rick's Generic GA Solver.  If not, see <http://www.gnu.org/licenses/>.
+
+***********************************************/
+/* 
+	persistent cache of a world's derived data
+*/
+
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <vector>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "world_cache.h"
+
+using namespace std;
+
+namespace
+{
+	const char magic[8] = {'R','G','A','W','O','R','L','D'};
+	const unsigned int version = 3;
+
+	// rounds offset up to the next 64 byte boundary.
+	unsigned long long int align(unsigned long long int offset)
+	{
+		return (offset + 63) & ~63ULL;
+	};
+};
+
+world_cache::world_cache()
+{
+	mapping = 0;
+	mapping_size = 0;
+	head = 0;
+};
+
+world_cache::~world_cache()
+{
+	close();
+};
+
+unsigned long long int world_cache::key(const city_list & cities)
+{
+	unsigned int n = cities.size();
+	unsigned long long int h = 0x9e3779b97f4a7c15ULL ^ n;
+	const float * axis[3] = {cities.x(), cities.y(), cities.z()};
+	for (int a=0; a < 3; a++)
+	{
+		for (unsigned int i=0; i < n; i++)
+		{
+			unsigned int bits;
+			memcpy(&bits, axis[a] + i, sizeof(bits));
+			h = (h ^ bits) * 0xff51afd7ed558ccdULL;
+			h = (h << 29) | (h >> 35);
+		};
+	};
+	h ^= h >> 33;
+	h *= 0xc4ceb9fe1a85ec53ULL;
+	h ^= h >> 33;
+	return h;
+};
+
+string world_cache::path(const string & directory, const settings & s)
+{
+	stringstream returnme;
+	returnme << directory << "/world_" << hex << setw(16) << setfill('0')
+		<< s.key << dec << "_" << s.cities << "_" << s.neighbors 
+		<< "_" << s.stride << "_" << s.numbering;
+	if (s.quantized)
+	{
+		// the scale goes in by its bits so every scale gets its own name.
+		unsigned long long int bits;
+		memcpy(&bits, &s.scale, sizeof(bits));
+		returnme << "_q" << s.quantized << "_" << hex << setw(0) << bits;
+	};
+	returnme << ".cache";
+	return returnme.str();
+};
+
+unsigned int world_cache::entry_size(const settings & s)
+{
+	return s.quantized ? s.quantized / 8 : sizeof(float);
+};
+
+world_cache::header world_cache::layout(const settings & s)
+{
+	header h;
+	memset(&h, 0, sizeof(h));
+	memcpy(h.magic, magic, sizeof(magic));
+	h.version = version;
+	h.cities = s.cities;
+	h.key = s.key;
+	h.neighbors = s.neighbors;
+	h.stride = s.stride;
+	h.numbering = s.numbering;
+	h.quantized = s.quantized;
+	h.scale = s.scale;
+	unsigned long long int n = s.cities;
+	h.table = align(sizeof(h));
+	h.near = align(h.table + n * s.stride * entry_size(s));
+	h.order = align(h.near + n * s.neighbors * sizeof(unsigned int));
+	h.size = h.order + n * sizeof(unsigned int);
+	return h;
+};
+
+bool world_cache::open(const string & filename, const settings & s)
+{
+	close();
+	int fd = ::open(filename.c_str(), O_RDONLY);
+	if (fd < 0) return false;
+	struct stat info;
+	header expected = layout(s);
+	if ((fstat(fd, &info) != 0) 
+		|| ((unsigned long long int) info.st_size != expected.size))
+	{
+		::close(fd);
+		return false;
+	};
+	void * block = mmap(0, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	::close(fd);
+	if (block == MAP_FAILED) return false;
+	mapping = block;
+	mapping_size = info.st_size;
+	head = (const header *) block;
+	if (memcmp(head, &expected, sizeof(header)) != 0)
+	{
+		close();
+		return false;
+	};
+	return true;
+};
+
+bool world_cache::write(const string & filename, const settings & s,
+	const void * table, const unsigned int * near, 
+	const unsigned int * order)
+{
+	header h = layout(s);
+	unsigned long long int n = s.cities;
+	// written under a temporary name and renamed into place.
+	string temp = filename + ".XXXXXX";
+	vector<char> name(temp.begin(), temp.end());
+	name.push_back(0);
+	int fd = mkstemp(&name[0]);
+	if (fd < 0) return false;
+	fchmod(fd, 0644);
+	::close(fd);
+	ofstream out(&name[0], ios::binary | ios::trunc);
+	const char zeros[64] = {0};
+	unsigned long long int at = 0;
+	// writes length bytes from data starting at offset, padding up to it.
+	auto put = [&](unsigned long long int offset, const void * data,
+		unsigned long long int length)
+	{
+		out.write(zeros, offset - at);
+		out.write((const char *) data, length);
+		at = offset + length;
+	};
+	put(0, &h, sizeof(h));
+	put(h.table, table, n * s.stride * entry_size(s));
+	put(h.near, near, n * s.neighbors * sizeof(unsigned int));
+	put(h.order, order, n * sizeof(unsigned int));
+	out.close();
+	if (!out || (rename(&name[0], filename.c_str()) != 0))
+	{
+		unlink(&name[0]);
+		return false;
+	};
+	return true;
+};
+
+void world_cache::close()
+{
+	if (mapping)
+	{
+		munmap(mapping, mapping_size);
+	};
+	mapping = 0;
+	mapping_size = 0;
+	head = 0;
+};
+
+const void * world_cache::table() const
+{
+	if (!head || !head->stride) return 0;
+	return (const char *) mapping + head->table;
+};
+
+const unsigned int * world_cache::neighbors() const
+{
+	if (!head) return 0;
+	return (const unsigned int *) ((const char *) mapping + head->near);
+};
+
+const unsigned int * world_cache::order() const
+{
+	if (!head) return 0;
+	return (const unsigned int *) ((const char *) mapping + head->order);
+};
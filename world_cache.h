@@ -0,0 +1,123 @@
+/***********************************************
+This file is part of the Rick's Generic GA Solver project (https://launchpad.net/ricks-ga).
+
+    Rick's Generic GA Solver is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Rick's Generic GA Solver is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Rick's Generic GA Solver.  If not, see <http://www.gnu.org/licenses/>.
+
+***********************************************/
+/* 
+	persistent cache of a world's derived data
+*/
+
+#ifndef world_cache_h
+#define world_cache_h
+
+#include <string>
+#include "city_list.h"
+
+/** A file holding the data world::load derives from a city list, so 
+ ** later runs on the same cities can map it instead of rebuilding it.
+ ** 
+ ** The file holds the distance table (if one was built), each city's 
+ ** nearest neighbor lists and the cities in space filling curve order,
+ ** which is also the internal numbering of renumbered worlds.
+ ** Its name comes from a hash of the city coordinates and the settings
+ ** that shape the data, so a changed city list or setting simply misses.
+ ** The header repeats all of these and is checked when the file is 
+ ** mapped.
+ ** 
+ ** Files are written under a temporary name and renamed into place, so
+ ** any number of processes may share a cache directory: a reader sees 
+ ** a whole file or none, and concurrent writers just replace each 
+ ** other's identical work. Mapped files are read only and shared, so 
+ ** processes on one host using the same file share its pages.
+ **/
+class world_cache
+{
+	public:
+		/// What a cache file was built from and for.
+		struct settings
+		{
+			unsigned long long int key;
+			unsigned int cities;
+			unsigned int neighbors;
+			// row length of the distance table; 0 if there is none.
+			unsigned int stride;
+			// world::numbering_type the data was built for.
+			unsigned int numbering;
+			// bits per quantized table entry, or 0 if it holds floats.
+			unsigned int quantized;
+			// table entry per unit of length when quantized, else 0.
+			double scale;
+		};
+		/// Bytes per distance table entry for settings s.
+		static unsigned int entry_size(const settings & s);
+		world_cache();
+		~world_cache();
+		/// Hash of the city count and coordinates.
+		static unsigned long long int key(const city_list & cities);
+		/// Name of the cache file for s in directory.
+		static std::string path(const std::string & directory, 
+			const settings & s);
+		/** Maps the cache file filename if it exists and was built with
+		 ** settings s.
+		 ** 
+		 ** Returns false, leaving nothing mapped, otherwise.
+		 **/
+		bool open(const std::string & filename, const settings & s);
+		/** Writes a cache file.
+		 ** 
+		 ** table is cities x stride entries of entry_size(s) bytes (ignored
+		 ** if s.stride is 0), 
+		 ** near is cities x neighbors city indexes and order is cities 
+		 ** city indexes. Returns false if the file could not be written;
+		 ** the cache is an optimization, so that is not fatal.
+		 **/
+		static bool write(const std::string & filename, const settings & s,
+			const void * table, const unsigned int * near, 
+			const unsigned int * order);
+		/// Unmaps the file, if any.
+		void close();
+		/// The distance table in the mapped file, or NULL.
+		const void * table() const;
+		/// The neighbor lists in the mapped file.
+		const unsigned int * neighbors() const;
+		/// The spatial ordering in the mapped file.
+		const unsigned int * order() const;
+	private:
+		struct header
+		{
+			char magic[8];
+			unsigned int version;
+			unsigned int cities;
+			unsigned long long int key;
+			unsigned int neighbors;
+			unsigned int stride;
+			unsigned int numbering;
+			unsigned int quantized;
+			double scale;
+			// byte offsets of the sections from the start of the file.
+			unsigned long long int table;
+			unsigned long long int near;
+			unsigned long long int order;
+			// total length of the file.
+			unsigned long long int size;
+		};
+		static header layout(const settings & s);
+		void * mapping;
+		size_t mapping_size;
+		const header * head;
+		world_cache(const world_cache &);
+};
+
+#endif // world_cache_h